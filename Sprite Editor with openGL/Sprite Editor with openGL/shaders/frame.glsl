@@ -0,0 +1,8 @@
+// Per-frame data shared by every shader, written once per frame into one uniform buffer.
+// loadShaderProgram inserts this file after the #version line of each shader.
+layout (std140) uniform FrameData
+{
+    mat4 viewProjection; // from level to clip space, follows the camera
+    vec4 viewport;       // width, height, 1 / width, 1 / height of the framebuffer in pixels
+    vec4 time;           // x seconds since start, y seconds since the last frame
+};
@@ -0,0 +1,7 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+void main()
+{
+    gl_Position = viewProjection * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+}
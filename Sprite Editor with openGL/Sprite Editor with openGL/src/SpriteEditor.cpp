@@ -4,7 +4,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -13,6 +19,223 @@ const unsigned int SCR_HEIGHT = 600;
 // a function template for resizing the viewport when the window is resized
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
+// compile and link a shader program from source files, or load it from the program binary cache,
+// and connect it to the per-frame uniform buffer
+unsigned int loadShaderProgram(const char* vertexPath, const char* fragmentPath);
+// look up the program binary functions, which GLAD does not load for OpenGL 3.3
+void loadProgramBinaryFunctions();
+
+// ================= program binary functions ================= //
+/* Program binaries are core in OpenGL 4.1 and available to 3.3 contexts through ARB_get_program_binary,
+ * which the GLAD loader was not generated with. The functions are looked up by hand and stay NULL
+ * when the driver does not have them, in which case programs are always compiled.
+ */
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+GetProgramBinaryProc getProgramBinary = NULL;
+ProgramBinaryProc programBinary = NULL;
+ProgramParameteriProc programParameteri = NULL;
+
+// the first bytes of a program binary cache file, followed by the binary itself
+struct ProgramBinaryHeader
+{
+    char magic[4];        // "GLPB"
+    uint32_t version;     // PROGRAM_BINARY_CACHE_VERSION
+    uint64_t key;         // hash of the shader sources and of the driver, see loadShaderProgram
+    uint32_t format;      // the binary format the driver reported
+    uint32_t length;      // bytes of binary after the header
+};
+const uint32_t PROGRAM_BINARY_CACHE_VERSION = 1;
+
+// ===================== per-frame uniforms ==================== //
+/* Camera, viewport and time are the same for every shader in a frame. They are written once per frame
+ * into one uniform buffer bound at FRAME_DATA_BINDING, and every program reads them from there through
+ * the FrameData block of shaders/frame.glsl, so no program needs glUniform calls for them.
+ */
+const GLuint FRAME_DATA_BINDING = 0;
+// the file with the FrameData block, inserted into every shader
+const char* const FRAME_DATA_SHADER = "shaders/frame.glsl";
+
+// the FrameData block in std140 layout: each member starts at a multiple of 16 bytes
+struct FrameData
+{
+    float viewProjection[16]; // column major
+    float viewport[4];        // width, height, 1 / width, 1 / height
+    float time[4];            // seconds since start, seconds since the last frame, unused, unused
+};
+static_assert(sizeof(FrameData) == 96, "FrameData must match the std140 layout of the FrameData block");
+
+// ======================= GL state cache ====================== //
+/* Every draw sets all the state it needs through glState, which remembers what is bound and only calls
+ * OpenGL when something actually changes. A redundant bind looks free, but the driver still validates
+ * it, so skipping it saves CPU time on every draw. Code that changes this state by calling OpenGL
+ * directly must call glState.invalidate() afterwards.
+ */
+const int STATE_CACHE_TEXTURE_UNITS = 16;
+const int STATE_CACHE_UNIFORM_BINDINGS = 8;
+// the cached state before anything was set, never a valid object name or size
+const GLuint UNKNOWN_BINDING = 0xFFFFFFFF;
+
+struct GLStateCache
+{
+    GLStateCache() { invalidate(); }
+
+    // forget the cached state, the next call of every kind goes to OpenGL
+    void invalidate()
+    {
+        program = UNKNOWN_BINDING;
+        vertexArray = UNKNOWN_BINDING;
+        for (int i = 0; i < BUFFER_TARGETS; i++) buffers[i] = UNKNOWN_BINDING;
+        for (int i = 0; i < STATE_CACHE_UNIFORM_BINDINGS; i++) uniformBindings[i] = UNKNOWN_BINDING;
+        activeUnit = UNKNOWN_BINDING;
+        for (int i = 0; i < STATE_CACHE_TEXTURE_UNITS; i++) textures[i] = UNKNOWN_BINDING;
+        blend = -1;
+        blendSource = blendDestination = UNKNOWN_BINDING;
+        viewportRect[0] = viewportRect[1] = viewportRect[2] = viewportRect[3] = -1;
+    }
+
+    void useProgram(GLuint id)
+    {
+        if (skip(id == program)) return;
+        glUseProgram(id);
+        program = id;
+    }
+
+    void bindVertexArray(GLuint id)
+    {
+        if (skip(id == vertexArray)) return;
+        glBindVertexArray(id);
+        vertexArray = id;
+        // the element array binding is part of the vertex array
+        buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_BINDING;
+    }
+
+    // bind a uniform buffer to an indexed binding point, which also binds it to GL_UNIFORM_BUFFER
+    void bindUniformBufferBase(GLuint index, GLuint id)
+    {
+        if (index < (GLuint)STATE_CACHE_UNIFORM_BINDINGS && skip(id == uniformBindings[index])) return;
+        glBindBufferBase(GL_UNIFORM_BUFFER, index, id);
+        if (index < (GLuint)STATE_CACHE_UNIFORM_BINDINGS) uniformBindings[index] = id;
+        buffers[bufferIndex(GL_UNIFORM_BUFFER)] = id;
+    }
+
+    void bindBuffer(GLenum target, GLuint id)
+    {
+        int index = bufferIndex(target);
+        if (index < 0)
+        {
+            glBindBuffer(target, id);
+            issued++;
+            return;
+        }
+        if (skip(id == buffers[index])) return;
+        glBindBuffer(target, id);
+        buffers[index] = id;
+    }
+
+    // bind a 2D texture to a texture unit, switching the active unit only if needed
+    void bindTexture(GLuint unit, GLuint id)
+    {
+        if (unit >= (GLuint)STATE_CACHE_TEXTURE_UNITS)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, id);
+            activeUnit = unit;
+            issued += 2;
+            return;
+        }
+        if (skip(id == textures[unit])) return;
+        if (!skip(unit == activeUnit))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+        glBindTexture(GL_TEXTURE_2D, id);
+        textures[unit] = id;
+    }
+
+    void setBlend(bool enabled)
+    {
+        if (skip(blend == (int)enabled)) return;
+        if (enabled) glEnable(GL_BLEND);
+        else glDisable(GL_BLEND);
+        blend = enabled;
+    }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (skip(source == blendSource && destination == blendDestination)) return;
+        glBlendFunc(source, destination);
+        blendSource = source;
+        blendDestination = destination;
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        if (skip(x == viewportRect[0] && y == viewportRect[1] && width == viewportRect[2] && height == viewportRect[3])) return;
+        glViewport(x, y, width, height);
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+    }
+
+    // close the counters of a frame, read them with lastFrameIssued and lastFrameSkipped
+    void endFrame()
+    {
+        lastFrameIssued = issued;
+        lastFrameSkipped = skipped;
+        issued = skipped = 0;
+    }
+
+    // state calls that reached OpenGL and that were skipped in the last finished frame
+    int lastFrameIssued = 0;
+    int lastFrameSkipped = 0;
+
+private:
+    static const int BUFFER_TARGETS = 3;
+
+    // slot of a cached buffer target, -1 for targets that are not cached
+    static int bufferIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        default: return -1;
+        }
+    }
+
+    // count a state call, true if it would not change anything
+    bool skip(bool redundant)
+    {
+        if (redundant) skipped++;
+        else issued++;
+        return redundant;
+    }
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint uniformBindings[STATE_CACHE_UNIFORM_BINDINGS];
+    GLuint activeUnit;
+    GLuint textures[STATE_CACHE_TEXTURE_UNITS];
+    int blend;
+    GLenum blendSource, blendDestination;
+    GLint viewportRect[4];
+    int issued = 0;
+    int skipped = 0;
+};
+
+// the one OpenGL context's state, also used by the resize callback
+GLStateCache glState;
 
 
 int main()
@@ -67,109 +290,23 @@ int main()
      * which we set equal to GLFW's window size.
      */
     // initial viewport
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    glState.viewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
     
     // ===================== create shaders ========================= //
-        // create the shader with code string, v330 means OpenGL 3.3
-    const char* vertexShaderSource = "#version 330 core\n"
-        "layout (location = 0) in vec3 aPos;\n"
-        "void main()\n"
-        "{\n"
-        "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-        "}\0";
-    // bind shader with id
-    unsigned int vertexShader;
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-
-    // dynamically compile the shader code
-    // The second argument specifies how many strings we're passing as source code
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // check if the compilation succeed
-    int  success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    // create the fragment shader
-    const char* fragmentShader1Source = "#version 330 core\n"
-        "out vec4 FragColor;\n"
-        "void main()\n"
-        "{\n"
-        "FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
-        "}\0";
-
-    const char* fragmentShader2Source = "#version 330 core\n"
-        "out vec4 FragColor;\n"
-        "void main()\n"
-        "{\n"
-        "   FragColor = vec4(1.0f, 1.0f, 0.0f, 1.0f);\n"
-        "}\n\0";
-    // bind, initialize and compile the fragment shader
-    unsigned int fragmentShaderOrange = glCreateShader(GL_FRAGMENT_SHADER); // the first fragment shader that outputs the color orange
-    unsigned int fragmentShaderYellow = glCreateShader(GL_FRAGMENT_SHADER); // the second fragment shader that outputs the color yellow
-    
-    
-    unsigned int shaderProgramOrange = glCreateProgram();
-    unsigned int shaderProgramYellow = glCreateProgram(); // the second shader program
-
-    glShaderSource(fragmentShaderOrange, 1, &fragmentShader1Source, NULL);
-    glCompileShader(fragmentShaderOrange);
-    // check if the compilation succeed
-    glGetShaderiv(fragmentShaderOrange, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShaderOrange, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    
-    glShaderSource(fragmentShaderYellow, 1, &fragmentShader2Source, NULL);
-    glCompileShader(fragmentShaderYellow);
-
-    glGetShaderiv(fragmentShaderYellow, GL_COMPILE_STATUS, &success);
-    if (!success)
+    /* The shader sources live in files next to the project. A linked program is also saved as a driver
+     * specific binary the first time it is built, and later runs load that binary instead of compiling
+     * and linking again, which is most of the startup cost once there are real sprite and tile shaders.
+     */
+    loadProgramBinaryFunctions();
+    // both programs share the vertex shader, they differ in the color their fragment shader outputs
+    unsigned int shaderProgramOrange = loadShaderProgram("shaders/triangle.vert", "shaders/orange.frag");
+    unsigned int shaderProgramYellow = loadShaderProgram("shaders/triangle.vert", "shaders/yellow.frag");
+    if (shaderProgramOrange == 0 || shaderProgramYellow == 0)
     {
-        glGetShaderInfoLog(fragmentShaderYellow, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    
-   
-    // ======================= Shading Program =================== //
-    // link both shader objects into a shader program that we can use for rendering
-    // create an empty program object
-    // link the first program object
-    glAttachShader(shaderProgramOrange, vertexShader);
-    glAttachShader(shaderProgramOrange, fragmentShaderOrange);
-    glLinkProgram(shaderProgramOrange);
-
-    // check if the linking succeed
-    glGetProgramiv(shaderProgramOrange, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgramOrange, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-
-    // then link the second program object using a different fragment shader (but same vertex shader)
-    // this is perfectly allowed since the inputs and outputs of both the vertex and fragment shaders are equally matched.
-    glAttachShader(shaderProgramYellow, vertexShader);
-    glAttachShader(shaderProgramYellow, fragmentShaderYellow);
-    glLinkProgram(shaderProgramYellow);
-
-    // check if the linking succeed
-    glGetProgramiv(shaderProgramYellow, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgramYellow, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        std::cout << "Failed to load the shader programs" << std::endl;
+        glfwTerminate();
+        return -1;
     }
-    // clean up the shaders
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShaderYellow);
-    glDeleteShader(fragmentShaderOrange);
     // =================== define VAO =========================== //
     // create a basic triangle
     float firstTriangle[] = {
@@ -188,18 +325,18 @@ int main()
     glGenBuffers(2, VBOs);
     // first triangle setup
     // --------------------
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
+    glState.bindVertexArray(VAOs[0]);
+    glState.bindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(firstTriangle), firstTriangle, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);	// Vertex attributes stay the same
     glEnableVertexAttribArray(0);
     // glBindVertexArray(0); // no need to unbind at all as we directly bind a different VAO the next few lines
     // ---------------------
     // 1. bind Vertex Array Object with id VAO
-    glBindVertexArray(VAOs[1]);	// note that we bind to a different VAO now
+    glState.bindVertexArray(VAOs[1]);	// note that we bind to a different VAO now
     // 2. copy our vertices array in a buffer for OpenGL to use
     // bind the VBO with corresponding, pre-defined openGL buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);	// and a different VBO
+    glState.bindBuffer(GL_ARRAY_BUFFER, VBOs[1]);	// and a different VBO
     // copy the triangle data into the GL_ARRAY_BUFFER -> occupied by the VBO
     /*
         *GL_STREAM_DRAW:  the data is set only once and used by the GPU at most a few times.
@@ -258,7 +395,27 @@ int main()
     // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
     glBindVertexArray(0);
     */
+    // ================= per-frame uniform buffer ================ //
+    // one buffer for the FrameData of every shader, bound once to its binding point
+    unsigned int frameDataUBO;
+    glGenBuffers(1, &frameDataUBO);
+    glState.bindBuffer(GL_UNIFORM_BUFFER, frameDataUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+    glState.bindUniformBufferBase(FRAME_DATA_BINDING, frameDataUBO);
+    // the camera looks at this point of the level, the vertices are already in clip space at zoom 1
+    float cameraX = 0.0f, cameraY = 0.0f, cameraZoom = 1.0f;
+    FrameData frameData = {};
+    double startTime = glfwGetTime(), previousFrameTime = startTime;
+
     // =================== Render Loop ========================== //
+    // every object sets all the state it draws with, the state cache drops what is already set
+    struct DrawObject { unsigned int program; unsigned int vertexArray; };
+    const DrawObject objects[] = {
+        { shaderProgramYellow, VAOs[0] }, // draw first triangle using the data from the first VAO
+        { shaderProgramOrange, VAOs[1] }  // then we draw the second triangle using the data from the second VAO
+    };
+    // the skipped state calls are shown in the window title once per second
+    double lastTitleTime = glfwGetTime();
     while (!glfwWindowShouldClose(window)) //  checks at the start of each loop iteration if GLFW has been instructed to close.
     {
         processInput(window);
@@ -268,21 +425,49 @@ int main()
         // Available bits: GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT and GL_STENCIL_BUFFER_BIT
         glClear(GL_COLOR_BUFFER_BIT); // state-using
 
-        // active the program
-        glUseProgram(shaderProgramYellow);
-        // draw first triangle using the data from the first VAO
-        glBindVertexArray(VAOs[0]);
-        glDrawArrays(GL_TRIANGLES, // type of primitives
-            0,  // starting index
-            3); // vertices to draw
-
-        // then we draw the second triangle using the data from the second VAO
-        glUseProgram(shaderProgramOrange);
-        glBindVertexArray(VAOs[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // ================ per-frame uniforms ================= //
+        // written once here, read by every draw of the frame
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        double now = glfwGetTime();
+        // scale by the zoom after moving the camera to the origin, column major
+        float* matrix = frameData.viewProjection;
+        for (int i = 0; i < 16; i++) matrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        matrix[0] = matrix[5] = cameraZoom;
+        matrix[12] = -cameraX * cameraZoom;
+        matrix[13] = -cameraY * cameraZoom;
+        frameData.viewport[0] = (float)framebufferWidth;
+        frameData.viewport[1] = (float)framebufferHeight;
+        frameData.viewport[2] = framebufferWidth > 0 ? 1.0f / framebufferWidth : 0.0f;
+        frameData.viewport[3] = framebufferHeight > 0 ? 1.0f / framebufferHeight : 0.0f;
+        frameData.time[0] = (float)(now - startTime);
+        frameData.time[1] = (float)(now - previousFrameTime);
+        previousFrameTime = now;
+        glState.bindBuffer(GL_UNIFORM_BUFFER, frameDataUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frameData);
+
+        for (const DrawObject& object : objects)
+        {
+            // active the program
+            glState.useProgram(object.program);
+            glState.bindVertexArray(object.vertexArray);
+            // the triangles are opaque
+            glState.setBlend(false);
+            glDrawArrays(GL_TRIANGLES, // type of primitives
+                0,  // starting index
+                3); // vertices to draw
+        }
 
         //glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // no unbinding of the VAO here, the next frame would only have to bind it again
+        glState.endFrame();
+        if (glfwGetTime() - lastTitleTime >= 1.0)
+        {
+            lastTitleTime = glfwGetTime();
+            std::string title = "LearnOpenGL - " + std::to_string(glState.lastFrameSkipped) + " of "
+                + std::to_string(glState.lastFrameIssued + glState.lastFrameSkipped) + " GL state calls skipped per frame";
+            glfwSetWindowTitle(window, title.c_str());
+        }
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window); // swap the color buffer (a large 2D buffer that contains color values for each pixel in GLFW's window)
         glfwPollEvents(); // checks if any events are triggered (like keyboard or mouse events), 
@@ -290,6 +475,7 @@ int main()
     }
 
     // ======================== QUIT ============================ //
+    glDeleteBuffers(1, &frameDataUBO);
     glfwTerminate();
     return 0;
 }
@@ -307,4 +493,205 @@ void processInput(GLFWwindow* window)
 
 // make sure the viewport matches the new window dimensions; note that width and 
 // height will be significantly larger than specified on retina displays.
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glViewport(0, 0, width, height); }
\ No newline at end of file
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) { glState.viewport(0, 0, width, height); }
+
+// ============================== SHADER PROGRAM BINARY CACHE ============================== //
+
+// read a whole file, empty if it cannot be read
+std::string readFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// 64 bit FNV-1a, good enough to tell shader sources and drivers apart
+uint64_t hashString(const std::string& text, uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void loadProgramBinaryFunctions()
+{
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+    programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+    programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+    // a driver with no binary formats cannot save programs even if it has the functions
+    if (formats == 0 || !getProgramBinary || !programBinary || !programParameteri)
+    {
+        getProgramBinary = NULL;
+        programBinary = NULL;
+        programParameteri = NULL;
+        std::cout << "Program binaries are not supported, shaders are compiled on every launch" << std::endl;
+    }
+}
+
+// compile one shader stage, 0 if it does not compile
+unsigned int compileShader(GLenum type, const std::string& source, const char* path)
+{
+    unsigned int shader = glCreateShader(type);
+    const char* code = source.c_str();
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::COMPILATION_FAILED " << path << "\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// shaders/triangle.vert and shaders/orange.frag are cached in shaders/triangle_orange.programbin
+std::string programCachePath(const std::string& vertexPath, const std::string& fragmentPath)
+{
+    size_t directoryEnd = vertexPath.find_last_of("/\\") + 1;
+    size_t vertexStart = directoryEnd, fragmentStart = fragmentPath.find_last_of("/\\") + 1;
+    std::string vertexName = vertexPath.substr(vertexStart, vertexPath.find_last_of('.') - vertexStart);
+    std::string fragmentName = fragmentPath.substr(fragmentStart, fragmentPath.find_last_of('.') - fragmentStart);
+    return vertexPath.substr(0, directoryEnd) + vertexName + "_" + fragmentName + ".programbin";
+}
+
+// load a program from its cache file, 0 if there is no usable binary for these sources and this driver
+unsigned int loadCachedProgram(const std::string& cachePath, uint64_t key)
+{
+    std::string cache = readFile(cachePath);
+    ProgramBinaryHeader header;
+    if (cache.size() < sizeof(header)) return 0;
+    memcpy(&header, cache.data(), sizeof(header));
+    if (memcmp(header.magic, "GLPB", 4) != 0 || header.version != PROGRAM_BINARY_CACHE_VERSION
+        || header.key != key || cache.size() - sizeof(header) != header.length)
+    {
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    programBinary(program, header.format, cache.data() + sizeof(header), (GLsizei)header.length);
+    // the driver may reject a binary of its own, e.g. after an update that kept the version string
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        std::cout << "Program binary " << cachePath << " was rejected, compiling the shaders" << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// write a linked program to its cache file, nothing is lost if that fails
+void saveCachedProgram(unsigned int program, const std::string& cachePath, uint64_t key)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    getProgramBinary(program, length, NULL, &format, binary.data());
+    ProgramBinaryHeader header;
+    memcpy(header.magic, "GLPB", 4);
+    header.version = PROGRAM_BINARY_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = (uint32_t)length;
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), length);
+    if (!file)
+    {
+        std::cout << "Program binary could not be written to " << cachePath << std::endl;
+    }
+}
+
+// read a shader and insert the FrameData block after its #version line, empty if it cannot be read
+// (compile errors past the #version line report line numbers shifted by the length of the block)
+std::string readShaderSource(const char* path)
+{
+    std::string source = readFile(path);
+    std::string frameData = readFile(FRAME_DATA_SHADER);
+    if (source.empty() || frameData.empty()) return std::string();
+    size_t versionEnd = source.find('\n');
+    // a shader of a single line has nothing after #version to put the block in front of
+    if (versionEnd == std::string::npos) source += '\n';
+    versionEnd = source.find('\n') + 1;
+    return source.substr(0, versionEnd) + frameData + source.substr(versionEnd);
+}
+
+// the program of loadShaderProgram, before it is connected to the per-frame uniform buffer
+unsigned int buildShaderProgram(const char* vertexPath, const char* fragmentPath)
+{
+    std::string vertexSource = readShaderSource(vertexPath);
+    std::string fragmentSource = readShaderSource(fragmentPath);
+    if (vertexSource.empty() || fragmentSource.empty())
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_READ " << (vertexSource.empty() ? vertexPath : fragmentPath) << std::endl;
+        return 0;
+    }
+
+    // a binary is only valid for the exact sources and driver it was built with
+    std::string cachePath = programCachePath(vertexPath, fragmentPath);
+    uint64_t key = hashString(vertexSource);
+    key = hashString(std::string(1, '\0') + fragmentSource, key);
+    key = hashString(std::string(1, '\0') + (const char*)glGetString(GL_VENDOR), key);
+    key = hashString(std::string(1, '\0') + (const char*)glGetString(GL_RENDERER), key);
+    key = hashString(std::string(1, '\0') + (const char*)glGetString(GL_VERSION), key);
+    if (programBinary)
+    {
+        unsigned int program = loadCachedProgram(cachePath, key);
+        if (program != 0) return program;
+    }
+
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, vertexPath);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, fragmentPath);
+    if (vertexShader == 0 || fragmentShader == 0)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    // ask the driver to keep the binary around for glGetProgramBinary
+    if (programParameteri) programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    // the program keeps what it needs of the shaders
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    if (getProgramBinary) saveCachedProgram(program, cachePath, key);
+    return program;
+}
+
+unsigned int loadShaderProgram(const char* vertexPath, const char* fragmentPath)
+{
+    unsigned int program = buildShaderProgram(vertexPath, fragmentPath);
+    if (program == 0) return 0;
+    // GLSL 3.30 cannot set the binding point in the shader, and a program loaded from a binary
+    // starts with the default binding, so it is set here for every program
+    GLuint blockIndex = glGetUniformBlockIndex(program, "FrameData");
+    // a shader that uses none of the block does not have it after linking
+    if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, blockIndex, FRAME_DATA_BINDING);
+    return program;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file Arena.hpp
+ * @brief This file contains the linear allocators for data that lives for one frame or one level.
+ *
+ * An arena hands out memory by moving a cursor through large blocks and
+ * never frees single allocations. All of it is given back at once: the frame
+ * arena is reset at the end of every loop iteration and the level arena is
+ * released when the level unloads.
+ *
+ * A reset keeps the memory of the arena. If the last frame needed more than
+ * one block, the blocks are merged into one as large as all of them, so after
+ * the first few frames a frame fits in one block and takes no malloc at all.
+ *
+ * The containers below use an arena for their storage. A container that
+ * grows leaves its old buffer behind in the arena until the reset, so reserve
+ * what is known up front. A container must not outlive the reset or release
+ * of its arena. Both arenas belong to the main thread.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Config.hpp"
+
+/**
+ * @brief Bump allocator over a chain of blocks, freed all at once.
+ */
+class Arena {
+public:
+
+    /**
+     * Constructor. No memory is allocated until the first Allocate().
+     * @param blockBytes Size of the blocks the arena takes from the heap.
+     */
+    explicit Arena(size_t blockBytes);
+
+    /**
+     * Destructor
+     */
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena &operator=(const Arena&) = delete;
+
+    /**
+     * Allocate memory that stays valid until the next Reset() or Release().
+     * @param bytes Size of the allocation.
+     * @param alignment A power of two.
+     */
+    void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Free every allocation but keep the memory for the next ones.
+     */
+    void Reset();
+
+    /**
+     * Free every allocation and give the memory back to the heap.
+     */
+    void Release();
+
+    /// Bytes allocated since the last reset, alignment padding included.
+    size_t GetUsedBytes() const { return usedBytes; }
+
+    /// The most bytes in use at once since the arena was created.
+    size_t GetPeakBytes() const { return peakBytes; }
+
+    /// Bytes the arena holds from the heap.
+    size_t GetCapacityBytes() const { return capacityBytes; }
+
+private:
+    /// A block of memory, its data follows the header.
+    struct Block {
+        Block *next;
+        size_t size;
+    };
+
+    /// Take a new block of at least bytes from the heap and make it current.
+    void AddBlock(size_t bytes);
+
+    /// Free every block.
+    void FreeBlocks();
+
+    /// Size of new blocks.
+    size_t blockBytes;
+    /// Every block, the current one first.
+    Block *blocks;
+    /// Free part of the current block.
+    Uint8 *cursor;
+    Uint8 *end;
+    /// Statistics, see the getters.
+    size_t usedBytes;
+    size_t peakBytes;
+    size_t capacityBytes;
+};
+
+/**
+ * @brief Standard allocator that takes its memory from an arena.
+ *
+ * deallocate() does nothing, the memory comes back when the arena is reset.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    /// Allocate from arena, which must outlive every container using it.
+    ArenaAllocator(Arena &arena) noexcept : arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.GetArena()) {}
+
+    T *allocate(size_t count) {
+        return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    /// The arena the memory comes from.
+    Arena *GetArena() const { return arena; }
+
+private:
+    Arena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.GetArena() == b.GetArena(); }
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return !(a == b); }
+
+/// A vector in an arena, e.g. ArenaVector<int> ids(GetFrameArena());
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+/// A string in an arena, for text built during a frame.
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+/// Temporary data of the frame being run, reset at the end of every loop iteration.
+Arena &GetFrameArena();
+
+/// Data of the level being edited, released when the level unloads.
+Arena &GetLevelArena();
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file AudioMixer.hpp
+ * @brief This file contains the software mixer that plays sound effects on the audio thread.
+ *
+ * Every SDL_mixer call that touches playing sounds locks the audio device,
+ * so calling them from the game thread can stall a frame for as long as the
+ * audio callback runs. This mixer instead runs inside the audio callback,
+ * as SDL_mixer's post mix step on top of the music, and owns its voices
+ * there. The game thread never touches a voice: Play(), StopVoice() and
+ * SetVolume() only push a command onto a wait-free single producer, single
+ * consumer queue, which the audio thread drains at the start of every
+ * callback. Nothing on either side takes a lock or allocates while sounds
+ * play.
+ *
+ * Sounds are decoded to float stereo at the device rate once, when they are
+ * loaded, and voices are summed into a float block with SSE or AVX, then
+ * added to the music with saturation in one pass.
+ *
+ * Mix() is public and needs no device, so the mixer can be driven directly,
+ * or through SDL's dummy audio driver, when there is no sound card.
+ */
+#ifndef AUDIO_MIXER_HPP
+#define AUDIO_MIXER_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <SDL_mixer.h>
+#include "Config.hpp"
+#include "SpscQueue.hpp"
+
+/// Index of a sound loaded into the mixer, -1 for none.
+typedef int SoundID;
+/// A playing sound, 0 for none. Handles are not reused until 2^32 sounds were played.
+typedef Uint32 VoiceHandle;
+
+/**
+ * @brief Mixes sound effects into the audio stream on the audio thread.
+ */
+class AudioMixer {
+public:
+
+    /**
+     * Constructor
+     */
+    AudioMixer();
+
+    /**
+     * Destructor
+     */
+    ~AudioMixer();
+
+    /**
+     * Start mixing into the open audio device.
+     * @return Whether the device is open in a format the mixer supports, 16 bit stereo.
+     */
+    bool Start();
+
+    /**
+     * Stop mixing. Once this returns the audio thread no longer runs the mixer.
+     */
+    void Stop();
+
+    /**
+     * Load a sound effect from a WAV, OGG or other file SDL_mixer can read.
+     * Game thread only, the audio device must be open.
+     * @return The sound, -1 if it could not be loaded.
+     */
+    SoundID LoadSound(const char *const soundPath);
+
+    /**
+     * Create a short sine beep that fades out, e.g. as a click for editor actions.
+     * @param frequency Pitch in Hz.
+     * @param seconds Length.
+     * @return The sound.
+     */
+    SoundID AddTone(float frequency, float seconds);
+
+    /**
+     * Start playing a sound. Never blocks.
+     * @param sound The sound.
+     * @param volume From 0 to 1.
+     * @param pan From -1, left, to 1, right.
+     * @param loop Whether to repeat the sound until it is stopped.
+     * @return The voice playing it, 0 if the command queue is full or the sound unknown.
+     */
+    VoiceHandle Play(SoundID sound, float volume = 1, float pan = 0, bool loop = false);
+
+    /// Length of a sound in seconds, 0 if the sound is unknown. Game thread only.
+    double GetSoundSeconds(SoundID sound) const;
+
+    /**
+     * Stop a voice. Never blocks. Voices that already finished are ignored.
+     */
+    void StopVoice(VoiceHandle voice);
+
+    /**
+     * Change the volume and pan of a voice. Never blocks.
+     */
+    void SetVolume(VoiceHandle voice, float volume, float pan = 0);
+
+    /**
+     * Stop every voice. Never blocks.
+     */
+    void StopAll();
+
+    /// Number of voices playing as of the last callback.
+    int GetActiveVoices() const { return activeVoices.load(std::memory_order_relaxed); }
+
+    /**
+     * Whether a voice may still be heard: its play command has not reached
+     * the audio thread yet, or it was playing as of the last callback.
+     * Never blocks.
+     */
+    bool IsVoicePlaying(VoiceHandle voice) const;
+
+    /// Number of commands dropped because the queue was full.
+    int GetDroppedCommands() const { return droppedCommands; }
+
+    /**
+     * Apply the queued commands and add the playing voices to a stream. Audio thread only.
+     * @param stream Interleaved 16 bit stereo samples, e.g. the music.
+     * @param frames Number of sample frames in the stream.
+     */
+    void Mix(Sint16 *stream, int frames);
+
+private:
+    /// Decoded samples of a sound, float stereo at the device rate.
+    struct SoundBuffer {
+        std::vector<float> samples;
+        int frames;
+    };
+
+    /// What the game thread asks the audio thread to do.
+    enum COMMAND_TYPE {
+        COMMAND_PLAY,
+        COMMAND_STOP,
+        COMMAND_VOLUME,
+        COMMAND_STOP_ALL
+    };
+
+    struct Command {
+        COMMAND_TYPE type;
+        VoiceHandle voice;
+        /// The sound to play, for COMMAND_PLAY. Sounds never move once loaded.
+        const SoundBuffer *sound;
+        float gainLeft;
+        float gainRight;
+        bool loop;
+    };
+
+    /// A sound being played, owned by the audio thread.
+    struct Voice {
+        /// nullptr if the voice is free.
+        const SoundBuffer *sound;
+        VoiceHandle handle;
+        int position;
+        float gainLeft;
+        float gainRight;
+        bool loop;
+    };
+
+    /// The post mix hook SDL_mixer calls on the audio thread.
+    static void SDLCALL MixCallback(void *mixer, Uint8 *stream, int len);
+
+    /// Queue a command, counting it as dropped if the queue is full.
+    bool Send(const Command &command);
+
+    /// Run the queued commands. Audio thread only.
+    void ApplyCommands();
+
+    /// The free or playing voice with a handle, nullptr if there is none.
+    Voice *FindVoice(VoiceHandle handle);
+
+    /// Add a block of decoded sound to a sound list, game thread only.
+    SoundID AddSound(std::vector<float> &&samples);
+
+    /// Volume and pan as the gain of each channel.
+    static void ToGains(float volume, float pan, float &gainLeft, float &gainRight);
+
+    /// Loaded sounds, game thread only. The buffers are shared with playing voices.
+    std::vector<std::unique_ptr<SoundBuffer>> sounds;
+    /// Handle of the next voice, game thread only.
+    VoiceHandle nextHandle;
+    /// Commands that did not fit into the queue, game thread only.
+    int droppedCommands;
+    /// Sample rate of the device.
+    int frequency;
+    /// Whether the mixer is hooked into the device.
+    bool running;
+
+    /// Commands from the game thread to the audio thread.
+    SpscQueue<Command, MIXER_QUEUE_SIZE> commands;
+    /// The voices, audio thread only.
+    Voice voices[MIXER_MAX_VOICES];
+    /// The voices summed for one block, audio thread only.
+    alignas(32) float mixBlock[MIXER_BLOCK_FRAMES * 2];
+    /// Number of playing voices, written by the audio thread.
+    std::atomic<int> activeVoices;
+    /// The newest voice whose play command was taken from the queue, audio thread only.
+    VoiceHandle lastPlayCommand;
+    /// Handle of every voice as of the last callback, 0 where it is free, written by the audio thread.
+    std::atomic<VoiceHandle> playingHandles[MIXER_MAX_VOICES];
+    /// lastPlayCommand as of the last callback, published after playingHandles.
+    std::atomic<VoiceHandle> appliedHandle;
+};
+
+#endif
@@ -0,0 +1,230 @@
+/**
+ * @file Autosaver.hpp
+ * @brief This file contains the background autosave of the level being edited.
+ *
+ * Every AUTOSAVE_INTERVAL_SECONDS the main thread copies the chunks edited
+ * since the last autosave, which only costs time for those chunks, and hands
+ * them to a worker thread. The worker appends them to a journal next to the
+ * level, each record with a CRC32, followed by a commit record, and syncs the
+ * file. A crash therefore loses at most the edits of one interval, and a
+ * torn write at the end of the journal is detected and ignored on recovery.
+ * A batch that fails to write is cut off the journal again, and its chunks
+ * are handed back so the next interval sends them once more.
+ *
+ * The journal is only created for the first batch, and removed again on
+ * Stop() if nothing was committed to it, so opening and closing the editor
+ * without an edit leaves no autosave and the level keeps being streamed.
+ *
+ * Once the journal grows past AUTOSAVE_COMPACT_BYTES, and at the start for a
+ * journal left by an earlier session, the worker writes a new base to a
+ * temporary file one chunk at a time: the newest committed chunks of the
+ * journal, the others decoded from the mapped base, or from the level if
+ * there is no base yet. The file is then renamed over the base in one atomic
+ * step and the journal removed, so the worker never holds the whole level.
+ * Recovery loads the base, or the level itself if there is none, and replays
+ * the committed records of the journal.
+ *
+ * Journal layout, all fields little endian:
+ *
+ *   AutosaveJournalHeader
+ *   records: AutosaveRecordHeader followed by payloadBytes bytes
+ */
+#ifndef AUTOSAVER_HPP
+#define AUTOSAVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/// Magic bytes at the start of an autosave journal.
+const char AUTOSAVE_JOURNAL_MAGIC[4] = {'L', 'V', 'A', 'J'};
+/// Current version of the journal layout.
+const Uint32 AUTOSAVE_JOURNAL_VERSION {1};
+/// Magic bytes at the start of every journal record.
+const char AUTOSAVE_RECORD_MAGIC[4] = {'A', 'S', 'R', 'C'};
+
+/// Kinds of journal records.
+enum AUTOSAVE_RECORD_TYPE {
+    /// The tiles of one chunk, TILE_CHUNK_SIZE rows of TILE_CHUNK_SIZE ids.
+    RECORD_CHUNK = 1,
+    /// The chunk records since the previous commit form a complete autosave.
+    RECORD_COMMIT
+};
+
+/// Start of an autosave journal.
+struct AutosaveJournalHeader {
+    char magic[4];
+    Uint32 version;
+    /// Size of the level the journal belongs to, in tiles.
+    Uint32 width;
+    Uint32 height;
+    /// Tiles per chunk side.
+    Uint32 chunkSize;
+};
+
+/// Start of every journal record.
+struct AutosaveRecordHeader {
+    char magic[4];
+    /// One of AUTOSAVE_RECORD_TYPE.
+    Uint32 type;
+    /// Number of the autosave the record belongs to.
+    Uint32 sequence;
+    /// Chunk index for RECORD_CHUNK, row by row.
+    Uint32 chunkIndex;
+    Uint32 payloadBytes;
+    /// CRC32 of this header, with checksum set to 0, followed by the payload.
+    Uint32 checksum;
+};
+
+static_assert(sizeof(AutosaveJournalHeader) == 20, "journal header must have no padding");
+static_assert(sizeof(AutosaveRecordHeader) == 24, "record header must have no padding");
+
+/**
+ * @brief Saves the edited chunks of a level off the main thread.
+ */
+class Autosaver {
+public:
+
+    /**
+     * Constructor
+     */
+    Autosaver();
+
+    /**
+     * Destructor. Stops the worker after it wrote everything handed to it.
+     */
+    ~Autosaver();
+
+    /**
+     * Start autosaving edits of a map. The map must currently hold what
+     * Recover() returns for the level, or the level itself if there is no autosave.
+     * @param levelPath The file name of the level being edited.
+     * @param map The map being edited.
+     */
+    void Start(const std::string &levelPath, const TileMap &map);
+
+    /**
+     * Hand the chunks edited since the last autosave to the worker, once
+     * AUTOSAVE_INTERVAL_SECONDS have passed. Call once per frame.
+     * @param map The map passed to Start().
+     */
+    void Update(const TileMap &map);
+
+    /**
+     * Hand every edited chunk to the worker now, e.g. before quitting.
+     */
+    void Flush(const TileMap &map);
+
+    /**
+     * Stop the worker after it wrote everything handed to it.
+     */
+    void Stop();
+
+    /**
+     * Whether the chunk as the map holds it now was handed to the worker, so
+     * the map may let go of it. True while autosave is not running, there is
+     * nothing to wait for then. Main thread only.
+     * @param map The map passed to Start().
+     */
+    bool IsChunkSaved(const TileMap &map, int chunkX, int chunkY) const;
+
+    /// Whether autosave is running, false once the worker gave up.
+    bool IsRunning() const { return running; }
+
+    /**
+     * @param levelPath The file name of a level.
+     * @return Whether an autosave of the level exists: a base, or a journal
+     *         with at least one committed chunk.
+     */
+    static bool HasAutosave(const std::string &levelPath);
+
+    /**
+     * Load the autosaved state of a level: the autosave base, or the level
+     * if there is none, with the committed journal records applied.
+     * @param levelPath The file name of the level.
+     * @param map Receives the level.
+     * @return Whether the level could be loaded.
+     */
+    static bool Recover(const std::string &levelPath, TileMap &map);
+
+    /**
+     * Delete the autosave of a level, e.g. after the level was saved for real.
+     */
+    static void Discard(const std::string &levelPath);
+
+private:
+    /// Copies of the chunks edited in one interval.
+    struct Batch {
+        std::vector<int> chunkIndices;
+        /// TILE_CHUNK_SIZE * TILE_CHUNK_SIZE ids per chunk, in the order of chunkIndices.
+        std::vector<TileID> tiles;
+    };
+
+    /// The worker thread: write batches until Stop().
+    void WorkerLoop();
+
+    /// Append a batch and its commit record to the journal and sync it.
+    bool WriteBatch(const Batch &batch);
+
+    /// Fold the committed chunks of the journal into a new base and remove the journal.
+    bool Compact();
+
+    /// Create an empty journal for a level of width x height tiles.
+    bool StartJournal();
+
+    /// Open the journal for appending, creating it if there is none.
+    bool OpenJournal();
+
+    /// Hand the chunks of a batch that could not be written back to Flush().
+    void ReturnChunks(const Batch &batch);
+
+    /// Close the journal if it is open.
+    void CloseJournal();
+
+    /// The file name of the level.
+    std::string levelPath;
+    /// The map's edit version of every chunk at the last autosave, main thread only.
+    std::vector<unsigned int> savedVersions;
+    /// When the last batch was handed over.
+    std::chrono::steady_clock::time_point lastSave;
+
+    /// Size of the level in tiles, set by Start().
+    int width;
+    int height;
+
+    /// The open journal, worker only.
+    FILE *journal;
+    /// Bytes in the journal, worker only.
+    size_t journalBytes;
+    /// Batches committed to the journal since it was created, worker only.
+    size_t committedBatches;
+    /// Journal size that triggers the next compaction, raised after one fails, worker only.
+    size_t compactThreshold;
+    /// Number of the next autosave, worker only.
+    Uint32 sequence;
+
+    /// Guards batches, unsavedChunks and stopping.
+    std::mutex mutex;
+    /// Wakes the worker when batches arrive or autosave stops.
+    std::condition_variable wakeWorker;
+    /// Batches waiting to be written, oldest first.
+    std::deque<Batch> batches;
+    /// Chunks of batches the worker could not write, to be sent again.
+    std::vector<int> unsavedChunks;
+    /// Set by Start(), cleared by Stop() or when the worker gives up.
+    std::atomic<bool> running;
+    /// Set to stop the worker once batches is empty.
+    bool stopping;
+    /// Writes batches off the main thread.
+    std::thread worker;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * @file Autotiler.hpp
+ * @brief This file contains the autotiler that picks edge and corner tiles for painted terrain.
+ *
+ * Every terrain cell looks at its 8 neighbours and packs which of them are
+ * terrain too into a byte. A 256 entry table, generated at compile time from
+ * the tiles of a terrain layout, turns that byte straight into the tile id to
+ * draw. An edit only changes the masks of its 3x3 neighbourhood, so only
+ * those cells are looked at again, and a bulk paint retiles its area once.
+ */
+#ifndef AUTOTILER_HPP
+#define AUTOTILER_HPP
+
+#include <array>
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/// Bits of the neighbour mask, clockwise from the top.
+enum NEIGHBOUR_BITS {
+    NEIGHBOUR_N = 1 << 0,
+    NEIGHBOUR_NE = 1 << 1,
+    NEIGHBOUR_E = 1 << 2,
+    NEIGHBOUR_SE = 1 << 3,
+    NEIGHBOUR_S = 1 << 4,
+    NEIGHBOUR_SW = 1 << 5,
+    NEIGHBOUR_W = 1 << 6,
+    NEIGHBOUR_NW = 1 << 7
+};
+
+/// The tiles of a terrain on the tile sheet: an outer 3x3 frame plus the inner corners.
+struct AutotileLayout {
+    TileID topLeft;
+    TileID top;
+    TileID topRight;
+    TileID left;
+    TileID center;
+    TileID right;
+    TileID bottomLeft;
+    TileID bottom;
+    TileID bottomRight;
+    /// Drawn when every side is terrain but the named diagonal is not.
+    TileID innerTopLeft;
+    TileID innerTopRight;
+    TileID innerBottomLeft;
+    TileID innerBottomRight;
+};
+
+/// Neighbour mask to tile id.
+typedef std::array<TileID, 256> AutotileTable;
+
+/**
+ * Pick the tile of a layout for every neighbour mask. Cells with open sides
+ * get edge or corner tiles, a strip one tile thin gets the edge on its open
+ * top or bottom first.
+ */
+constexpr AutotileTable MakeAutotileTable(const AutotileLayout &layout) {
+    AutotileTable table {};
+    for (int mask = 0; mask < 256; mask++) {
+        bool n = mask & NEIGHBOUR_N, e = mask & NEIGHBOUR_E, s = mask & NEIGHBOUR_S, w = mask & NEIGHBOUR_W;
+        TileID id = layout.center;
+        if (!n) id = !w ? layout.topLeft : !e ? layout.topRight : layout.top;
+        else if (!s) id = !w ? layout.bottomLeft : !e ? layout.bottomRight : layout.bottom;
+        else if (!w) id = layout.left;
+        else if (!e) id = layout.right;
+        else if (!(mask & NEIGHBOUR_NW)) id = layout.innerTopLeft;
+        else if (!(mask & NEIGHBOUR_NE)) id = layout.innerTopRight;
+        else if (!(mask & NEIGHBOUR_SW)) id = layout.innerBottomLeft;
+        else if (!(mask & NEIGHBOUR_SE)) id = layout.innerBottomRight;
+        table[mask] = id;
+    }
+    return table;
+}
+
+/**
+ * The rock terrain framed with grass in the top left 6x6 tiles of Tiles1.bmp.
+ * The sheet draws that frame around an open cave and has no rock tiles with a
+ * notch cut out of one corner, so the inner corners fall back to the center
+ * tile on purpose: a missing diagonal is drawn as solid rock.
+ */
+constexpr AutotileLayout TILES1_ROCK_LAYOUT {
+    0, 4, 5,
+    16, 17, 21,
+    80, 81, 85,
+    17, 17, 17, 17
+};
+
+constexpr AutotileTable TILES1_ROCK_AUTOTILE = MakeAutotileTable(TILES1_ROCK_LAYOUT);
+
+static_assert(TILES1_ROCK_AUTOTILE[0xFF] == TILES1_ROCK_LAYOUT.center, "a surrounded cell is drawn with the center tile");
+static_assert(TILES1_ROCK_LAYOUT.innerTopLeft == TILES1_ROCK_LAYOUT.center
+              && TILES1_ROCK_LAYOUT.innerTopRight == TILES1_ROCK_LAYOUT.center
+              && TILES1_ROCK_LAYOUT.innerBottomLeft == TILES1_ROCK_LAYOUT.center
+              && TILES1_ROCK_LAYOUT.innerBottomRight == TILES1_ROCK_LAYOUT.center,
+              "Tiles1.bmp has no inner corner tiles, they are drawn with the center tile");
+static_assert(TILES1_ROCK_AUTOTILE[0xFF & ~NEIGHBOUR_NW] == TILES1_ROCK_LAYOUT.center,
+              "a cell missing only a diagonal neighbour is drawn as solid rock");
+static_assert(TILES1_ROCK_AUTOTILE[NEIGHBOUR_E | NEIGHBOUR_S] == TILES1_ROCK_LAYOUT.topLeft, "a cell open to the top left is the top left corner");
+
+/**
+ * @brief Paints one terrain into a TileMap and keeps its edges and corners right.
+ */
+class Autotiler {
+public:
+
+    /**
+     * Constructor
+     * @param table Neighbour mask to tile id, see MakeAutotileTable(). Every id in
+     *        it counts as part of the terrain.
+     */
+    Autotiler(const AutotileTable &table = TILES1_ROCK_AUTOTILE);
+
+    /**
+     * Destructor
+     */
+    ~Autotiler();
+
+    /// Whether a tile id belongs to this terrain.
+    bool IsTerrain(TileID id) const;
+
+    /**
+     * Add terrain to, or erase terrain from, one cell and retile its 3x3 neighbourhood.
+     * @param map The map to paint into.
+     * @param x Tile column.
+     * @param y Tile row.
+     * @param terrain Whether the cell becomes terrain or empty.
+     */
+    void Paint(TileMap &map, int x, int y, bool terrain);
+
+    /**
+     * Paint a rectangle of cells and retile it, plus the ring of cells around it, once.
+     * @param area Tile columns and rows to paint, clipped to the map.
+     * @param terrain Whether the cells become terrain or empty.
+     */
+    void PaintRect(TileMap &map, const SDL_Rect &area, bool terrain);
+
+    /**
+     * Pick the tile of every terrain cell in an area from its neighbours. Cells
+     * that are not terrain are left alone.
+     * @param area Tile columns and rows to retile, clipped to the map.
+     * @param changes If given, the rows that were rewritten are added to it.
+     */
+    void Retile(TileMap &map, const SDL_Rect &area, TileChangeSet *changes = nullptr);
+
+private:
+    /// Read a row of the map, one cell wider on each side, as terrain flags.
+    void ReadRow(const TileMap &map, int y, int x, int count, std::vector<Uint8> &out);
+
+    /// Neighbour mask to tile id.
+    AutotileTable table;
+    /// Terrain flag of every tile id, indexed by id.
+    std::vector<bool> terrainIds;
+    /// Buffers for the rows being retiled, kept to avoid allocating per edit.
+    std::vector<TileID> rowIds;
+    std::vector<TileID> retiledIds;
+    std::vector<Uint8> above;
+    std::vector<Uint8> row;
+    std::vector<Uint8> below;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file Benchmarks.hpp
+ * @brief This file contains the benchmarks that can be started from the command line.
+ *
+ * Each benchmark prints its timings to stdout and returns an exit code for main().
+ */
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include "Config.hpp"
+
+/**
+ * Generate a size x size text level and load it with the legacy istream loader
+ * and with LevelTextParser on one thread and on every core.
+ * @param size Number of tile rows and columns of the generated level.
+ * @return 0 if every loader produced the same map.
+ */
+int RunLevelParserBenchmark(int size);
+
+/**
+ * Let entities walk around the listener and trigger their sounds every
+ * update through a VoiceManager, with the AudioMixer driven directly
+ * instead of by an audio device.
+ * @param entities Number of sound making entities.
+ * @return 0 if the voices stayed within VOICE_BUDGET.
+ */
+int RunVoiceBenchmark(int entities);
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file Camera.hpp
+ * @brief This file contains the camera that decides which part of the level is on screen.
+ *
+ * Everything in the level is positioned in level pixels. The camera maps a
+ * viewport sized rectangle of the level onto the screen, and tells renderers
+ * which tiles fall inside it so they never look at the rest of the level.
+ */
+#ifndef CAMERA_HPP
+#define CAMERA_HPP
+
+#include "Config.hpp"
+
+/// An inclusive rectangle of tile indices. Empty when lastX < firstX or lastY < firstY.
+struct TileRange {
+    int firstX;
+    int firstY;
+    int lastX;
+    int lastY;
+
+    /// Whether the range holds no tile.
+    bool IsEmpty() const { return lastX < firstX || lastY < firstY; }
+};
+
+/**
+ * @brief A viewport sized window into the level.
+ */
+class Camera {
+public:
+
+    /**
+     * Constructor
+     */
+    Camera();
+
+    /**
+     * Constructor
+     * @param viewportWidth Width of the area shown on screen, in pixels.
+     * @param viewportHeight Height of the area shown on screen, in pixels.
+     */
+    Camera(int viewportWidth, int viewportHeight);
+
+    /**
+     * Destructor
+     */
+    ~Camera();
+
+    /**
+     * Change the size of the area shown on screen.
+     */
+    void SetViewport(int viewportWidth, int viewportHeight);
+
+    /**
+     * Keep the view inside a level of the given size. 0 turns clamping off.
+     * @param levelWidth Width of the level in pixels.
+     * @param levelHeight Height of the level in pixels.
+     */
+    void SetBounds(int levelWidth, int levelHeight);
+
+    /**
+     * Put the top left corner of the view at a level position.
+     */
+    void SetPosition(int x, int y);
+
+    /**
+     * Move the view by an offset in pixels.
+     */
+    void Move(int dx, int dy);
+
+    /**
+     * Center the view on a level position.
+     */
+    void CenterOn(int x, int y);
+
+    /// The area of the level, in pixels, that is shown on screen.
+    const SDL_Rect &GetView() const { return view; }
+
+    /**
+     * @param rect An area of the level in pixels.
+     * @return Whether any part of the area is on screen.
+     */
+    bool IsVisible(const SDL_Rect &rect) const;
+
+    /**
+     * @param rect An area of the level in pixels.
+     * @return The same area in screen pixels.
+     */
+    SDL_Rect ToScreen(const SDL_Rect &rect) const;
+
+    /**
+     * @param tileSize Size of a grid cell in pixels.
+     * @param cols Number of grid columns, the range is clipped to the grid.
+     * @param rows Number of grid rows.
+     * @return The cells of a grid that overlap the view.
+     */
+    TileRange GetVisibleRange(int tileSize, int cols, int rows) const;
+
+private:
+    /// Move the view back inside the level bounds.
+    void Clamp();
+
+    /// The area of the level shown on screen.
+    SDL_Rect view;
+    /// Width of the level in pixels, 0 if unbounded.
+    int levelWidth;
+    /// Height of the level in pixels, 0 if unbounded.
+    int levelHeight;
+};
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * @file ChunkStreamer.hpp
+ * @brief This file contains the pager that keeps only the chunks around the camera in memory.
+ *
+ * The level is a memory mapped binary level. A worker thread decodes the
+ * chunks the camera needs, which is where the pages are actually read from
+ * disk, and the main thread moves finished chunks into the TileMap a few at
+ * a time. Chunks are requested around the camera and around the position
+ * the camera is heading to, and paged out again once they are out of range.
+ *
+ * Until a chunk with tiles in the file is installed, and again once it is
+ * paged out, it is marked absent in the map, so edits cannot land in it and
+ * be overwritten or lost when the chunk comes in.
+ *
+ * Edited chunks are paged out like the others, once the autosave has them:
+ * their tiles go to a spill file next to the level, one slot per chunk, and
+ * come back from there. The map thus only ever holds the chunks around the
+ * camera, however many chunks were edited.
+ */
+#ifndef CHUNK_STREAMER_HPP
+#define CHUNK_STREAMER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arena.hpp"
+#include "Autosaver.hpp"
+#include "Config.hpp"
+#include "LevelFile.hpp"
+#include "TileMap.hpp"
+
+/**
+ * @brief Streams the chunks of a binary level into a TileMap around the camera.
+ */
+class ChunkStreamer {
+public:
+
+    /**
+     * Constructor
+     */
+    ChunkStreamer();
+
+    /**
+     * Destructor
+     */
+    ~ChunkStreamer();
+
+    /**
+     * Map a binary level, size the map to it and start the worker thread.
+     * No chunk is loaded until the first Update().
+     * @param filePath The file name of the binary level.
+     * @param map The map chunks are streamed into. It must outlive the streamer.
+     * @return Whether the level could be opened.
+     */
+    bool Open(const std::string &filePath, TileMap *map);
+
+    /**
+     * Stop the worker thread, unmap the level and delete the spill file. The
+     * map keeps its resident chunks, and the chunks that were not loaded stay
+     * absent, edited ones included; the autosave holds their edits.
+     */
+    void Close();
+
+    /**
+     * Keep edited chunks in memory until the autosave has them, see
+     * Autosaver::IsChunkSaved(). Without an autosaver edited chunks are paged
+     * out right away.
+     * @param autosaver The autosave of the level, may be nullptr.
+     */
+    void SetAutosaver(const Autosaver *autosaver) { this->autosaver = autosaver; }
+
+    /// Whether a level is being streamed.
+    bool IsOpen() const { return tileMap != nullptr; }
+
+    /**
+     * @param radius Chunks kept in memory in every direction around the camera.
+     */
+    void SetResidentRadius(int radius);
+
+    /**
+     * Install finished chunks, page out chunks that fell out of range and request the
+     * chunks around the camera and its predicted position. Call once per frame.
+     * @param view The area of the level, in pixels, that the camera shows.
+     */
+    void Update(const SDL_Rect &view);
+
+    /// Number of chunks currently held in the map by the streamer.
+    int GetResidentCount() const { return (int)residentChunks.size(); }
+
+private:
+    /// Where a chunk is in its way from the file into the map.
+    enum CHUNK_STATE {
+        CHUNK_NOT_RESIDENT = 0,
+        CHUNK_REQUESTED,
+        CHUNK_RESIDENT
+    };
+
+    /// A chunk decoded by the worker.
+    struct LoadedChunk {
+        int chunkIndex;
+        std::vector<TileID> tiles;
+    };
+
+    /// The worker thread: decode requested chunks until Close().
+    void WorkerLoop();
+
+    /// Whether a chunk lies within radius chunks of the camera or of its predicted position.
+    bool InRange(int chunkIndex, int radius) const;
+
+    /// Whether a chunk has tiles outside of the map, in the level or in the spill file.
+    bool HasStoredTiles(int chunkIndex) const;
+
+    /// Write the tiles of a resident chunk to its slot of the spill file.
+    bool SpillChunk(int chunkIndex);
+
+    /// Read a chunk back from its slot of the spill file.
+    bool ReadSpilledChunk(Uint32 slot, TileID *out);
+
+    /// The map chunks are streamed into.
+    TileMap *tileMap;
+    /// The mapped level, read by the worker only.
+    LevelFile level;
+    /// Whether edited chunks may be paged out yet, may be nullptr.
+    const Autosaver *autosaver;
+
+    /// Chunks kept in every direction around the camera.
+    int residentRadius;
+
+    /// The chunk under the center of the view.
+    int cameraChunkX, cameraChunkY;
+    /// The chunk under the center of the view STREAM_PREFETCH_SECONDS from now.
+    int predictedChunkX, predictedChunkY;
+    /// Camera velocity in pixels per second, smoothed over frames.
+    double velocityX, velocityY;
+    /// The view center at the last Update().
+    double lastCenterX, lastCenterY;
+    /// When the last Update() ran.
+    std::chrono::steady_clock::time_point lastUpdate;
+    /// Whether Update() ran before since Open().
+    bool hasLastUpdate;
+
+    /// CHUNK_STATE of every chunk of the level, main thread only, in the level arena.
+    ArenaVector<Uint8> chunkStates;
+    /// The map's edit version of the tiles the level or the spill file holds for each chunk.
+    ArenaVector<unsigned int> storedEditVersions;
+    /// The spill file slot of each chunk, NO_SPILL_SLOT for chunks never spilled.
+    ArenaVector<Uint32> spillSlots;
+    /// Chunks in CHUNK_RESIDENT state.
+    std::vector<int> residentChunks;
+
+    /// Guards requests, results and stopping.
+    std::mutex mutex;
+    /// Wakes the worker when requests arrive or the streamer closes.
+    std::condition_variable wakeWorker;
+    /// Chunks to decode, nearest to the camera first.
+    std::deque<int> requests;
+    /// Chunks the worker finished and the main thread has not installed yet.
+    std::vector<LoadedChunk> results;
+    /// The results being installed, swapped with results to keep the capacity of both.
+    std::vector<LoadedChunk> installing;
+    /// Set to stop the worker.
+    bool stopping;
+
+    /// File name of the spill file.
+    std::string spillPath;
+    /// Edited chunks paged out of the map, created on the first spill.
+    FILE *spillFile;
+    /// Slots used in the spill file.
+    Uint32 spillCount;
+    /// Guards the spill file, written by the main thread and read by the worker.
+    std::mutex spillMutex;
+    /// Decodes chunks off the main thread.
+    std::thread worker;
+};
+
+#endif
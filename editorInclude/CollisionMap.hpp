@@ -0,0 +1,162 @@
+/**
+ * @file CollisionMap.hpp
+ * @brief This file contains the collision queries against the solid tiles of a level.
+ *
+ * A tile property table says which tile ids are solid. From it and a TileMap
+ * the collision map keeps one bit per tile, a word per chunk row, so a query
+ * tests a whole row of a bounding box with a few mask operations instead of
+ * reading tile ids one at a time. Only chunks with a solid tile hold a mask,
+ * so a streamed level costs memory for the chunks in memory, and only the
+ * chunks the map reports as changed are derived again. Chunks that are absent
+ * from the map, see TileMap::SetChunkAbsent(), count as solid: nothing moves
+ * into terrain that is not known yet.
+ */
+#ifndef COLLISION_MAP_HPP
+#define COLLISION_MAP_HPP
+
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/// Which sides of a box touch solid tiles, see CollisionMap::GetContacts().
+enum CONTACT_FLAGS {
+    CONTACT_NONE = 0,
+    CONTACT_GROUND = 1 << 0,
+    CONTACT_CEILING = 1 << 1,
+    CONTACT_LEFT = 1 << 2,
+    CONTACT_RIGHT = 1 << 3
+};
+
+/// The outcome of CollisionMap::Sweep().
+struct SweepResult {
+    /// How far the box may move without entering a solid tile, in pixels.
+    int dx;
+    int dy;
+    /// Whether the horizontal or vertical movement was cut short.
+    bool hitX;
+    bool hitY;
+};
+
+/**
+ * @brief One bit per tile of a level telling whether the tile blocks movement.
+ */
+class CollisionMap {
+public:
+
+    /**
+     * Constructor. Every non-empty tile is solid until SetSolid() says otherwise.
+     */
+    CollisionMap();
+
+    /**
+     * Destructor
+     */
+    ~CollisionMap();
+
+    /**
+     * Change the tile property table. Takes effect on the next Build().
+     * @param id The tile id.
+     * @param solid Whether tiles with this id block movement.
+     */
+    void SetSolid(TileID id, bool solid);
+
+    /// Whether tiles with this id block movement.
+    bool IsSolidId(TileID id) const;
+
+    /**
+     * Derive the whole mask from a map.
+     */
+    void Build(const TileMap &map);
+
+    /**
+     * Derive the mask again for the chunks of the map that changed since the
+     * last Build() or Update(), see TileMap::TakeChangedChunks(). Rebuilds
+     * everything if the map changed size.
+     */
+    void Update(TileMap &map);
+
+    /**
+     * Derive the mask again for the chunks one operation changed, right away.
+     * @param map The map the operation changed.
+     * @param changes What the operation changed.
+     */
+    void Apply(const TileMap &map, const TileChangeSet &changes);
+
+    /// Width of the mask in tiles.
+    int GetWidth() const { return width; }
+    /// Height of the mask in tiles.
+    int GetHeight() const { return height; }
+
+    /// Whether a tile is solid. Tiles outside of the level are not, tiles of absent chunks are.
+    bool IsSolidTile(int x, int y) const;
+
+    /// Whether the tile under a level pixel is solid.
+    bool IsSolidPoint(int px, int py) const;
+
+    /**
+     * @param area An area of the level in pixels.
+     * @return Whether any solid tile overlaps the area.
+     */
+    bool IsAreaSolid(const SDL_Rect &area) const;
+
+    /**
+     * @param box A bounding box in level pixels.
+     * @return CONTACT_FLAGS of the sides that rest against solid tiles.
+     */
+    int GetContacts(const SDL_Rect &box) const;
+
+    /**
+     * Move a box by (dx, dy), first horizontally then vertically, stopping it
+     * flush against the first solid tile in the way. The box should not start
+     * inside a solid tile.
+     * @param box A bounding box in level pixels.
+     * @param dx Horizontal movement in pixels.
+     * @param dy Vertical movement in pixels.
+     */
+    SweepResult Sweep(const SDL_Rect &box, int dx, int dy) const;
+
+    /**
+     * Walk the tiles a segment passes through, in order.
+     * @param x0, y0 Start of the segment in level pixels.
+     * @param x1, y1 End of the segment in level pixels.
+     * @param hitX, hitY Receive the first solid tile on the segment, if any.
+     * @return Whether the segment touches a solid tile.
+     */
+    bool Raycast(int x0, int y0, int x1, int y1, int &hitX, int &hitY) const;
+
+private:
+    /// Derive the mask of one chunk.
+    void BuildChunk(const TileMap &map, int chunkX, int chunkY);
+
+    /// The bits of a chunk row, lowest bit for the leftmost tile.
+    Uint64 GetChunkRowBits(int chunkX, int y) const;
+
+    /// Whether any tile of [firstX, lastX] in a row is solid. Columns are clipped to the level.
+    bool IsRowSpanSolid(int y, int firstX, int lastX) const;
+
+    /**
+     * The first solid tile of [firstX, lastX] in a row, scanning from firstX
+     * towards lastX, which may lie either side of it.
+     * @return The tile column, or -1 if there is none.
+     */
+    int FindSolidInRow(int y, int firstX, int lastX) const;
+
+    /// Solid flag of every tile id, indexed by id.
+    std::vector<bool> solidIds;
+    int width;
+    int height;
+    int chunkCols;
+    int chunkRows;
+    /// Per chunk, row by row: the first row of its mask in maskRows, or MASK_CLEAR or MASK_ABSENT.
+    std::vector<int> chunkMasks;
+    /// TILE_CHUNK_SIZE words per chunk with a solid tile, one per chunk row.
+    std::vector<Uint64> maskRows;
+    /// Masks in maskRows no chunk uses any more, by their first row.
+    std::vector<int> freeMasks;
+    /// The map's chunk version each chunk of the mask was derived from.
+    std::vector<unsigned int> builtVersions;
+    /// Chunks the map reported as changed, kept to avoid allocating per update.
+    std::vector<int> changedChunks;
+};
+
+#endif
@@ -27,6 +27,14 @@ const int CHARACTER_HEIGHT {128};
 const int WINDOW_WIDTH {128};
 const int WINDOW_HEIGHT {128};
 
+// width and height of a spatial hash cell, about the size of a character
+const int SPATIAL_CELL_SIZE {128};
+
+// division that rounds towards negative infinity, so pixel -1 lands in tile, chunk or cell -1
+inline int FloorDiv(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
 enum IMG_STATE {
     FILE_COL = 0,
     FILE_ROW,
@@ -49,6 +57,13 @@ enum IMG_FILES {
 };
 const int SPRITE_INFO_NUM {5};
 
+// bit masks that group sprites for overlap checks
+enum SPRITE_LAYER {
+	LAYER_PLAYER = 1 << 0,
+	LAYER_ENEMY = 1 << 1,
+	LAYER_SCENERY = 1 << 2
+};
+
 // ===================== player ====================== //
 const char* const CHAR_IDLE_SPRITE = "../assets/images/character/Idle (32x32).png";
 const int CHAR_IDLE_IMG_INFO[SPRITE_INFO_NUM] = {10,0,32,32,5};
@@ -82,4 +97,78 @@ const int ENEMY_HIT_IMG_INFO[SPRITE_INFO_NUM] = {4,0,36,30,3};
 const char *const BACKGROUND_IMG_FILE = "./../assets/images/background.png";
 const int STILL_SPRITE_INFO[SPRITE_INFO_NUM] = {-1,-1,-1,-1,-1};
 
+// sprites the resource manager can hold at once, the ones above plus room for spawned ones
+const int SPRITE_POOL_SIZE {64};
+// fill the slots of released pool objects with a pattern and check it on reuse, for debugging
+const bool POOL_POISON {false};
+
+// ==================== simulation ==================== //
+// fixed updates per second of the editor, and of the sessions it records
+const int UPDATES_PER_SECOND {60};
+// while fast-forwarding, progress is printed after this many updates, ten minutes of simulated time
+const int FAST_FORWARD_REPORT_TICKS {UPDATES_PER_SECOND * 60 * 10};
+// block size of the arena for temporary data of a frame, enough for a frame without growing
+const size_t FRAME_ARENA_BYTES {256 * 1024};
+// block size of the arena for data that lives as long as the level
+const size_t LEVEL_ARENA_BYTES {1024 * 1024};
+
+// ==================== tile map ====================== //
+const char* const TILE_SHEET_FILE = "../assets/images/Tiles1.bmp";
+const char* const DEFAULT_LEVEL_FILE = "../assets/levels/default-level";
+// width and height of a single tile, both on the tile sheet and in the game
+const int TILE_SIZE {32};
+// number of tiles along each side of a baked chunk texture
+const int TILE_CHUNK_SIZE {16};
+// chunks kept in memory around the camera when a binary level is streamed
+const int STREAM_RESIDENT_RADIUS {2};
+// how far ahead, in seconds of camera movement, chunks are requested before they are needed
+const double STREAM_PREFETCH_SECONDS {0.75};
+// finished chunk reads moved into the level per frame, to spread the work over frames
+const int STREAM_MAX_INSTALLS_PER_FRAME {8};
+// memory the undo history of the level editor may use before the oldest edits are forgotten
+const size_t EDIT_JOURNAL_MAX_BYTES {16 * 1024 * 1024};
+// seconds between autosaves of the edited chunks
+const double AUTOSAVE_INTERVAL_SECONDS {5.0};
+// size the autosave journal may reach before it is folded into the autosave base
+const size_t AUTOSAVE_COMPACT_BYTES {4 * 1024 * 1024};
+
+// ====================== text ======================== //
+const char* const FONT_FILE = "../assets/fonts/DejaVuSansMono.ttf";
+// size of the on-screen text in points, small enough for the sprite menu to fit the window
+const int FONT_SIZE {9};
+
+// ================ performance overlay =============== //
+// frames shown by the frame time graph, one pixel column each
+const int PERF_GRAPH_FRAMES {120};
+// height of the frame time graph in pixels
+const int PERF_GRAPH_HEIGHT {32};
+// frame time at the top of the graph, in milliseconds
+const double PERF_GRAPH_MAX_MS {100.0 / 3};
+// frame time the editor aims for, drawn as a line across the graph
+const double PERF_FRAME_BUDGET_MS {1000.0 / 60};
+// input to present latencies are counted in buckets of one millisecond up to this, longer ones share the last bucket
+const int INPUT_LATENCY_MAX_MS {128};
+
+// ===================== audio ======================== //
+const char* const MUSIC_FILE = "../assets/musics/next-gen-game-bgm.mp3";
+// sample rate and channels of the audio device
+const int AUDIO_FREQUENCY {44100};
+const int AUDIO_CHANNELS {2};
+// sample frames the audio device asks for at once, small enough for sound effects to start quickly
+const int AUDIO_BUFFER_FRAMES {1024};
+// volume of the background music, from 0 to 1
+const double MUSIC_VOLUME {0.5};
+// sound effects the mixer plays at the same time
+const int MIXER_MAX_VOICES {32};
+// commands the game thread can queue for the mixer before it gets to them, a power of two
+const int MIXER_QUEUE_SIZE {256};
+// sample frames the mixer sums at a time, whatever the device asks for
+const int MIXER_BLOCK_FRAMES {256};
+// sound effects started by the voice manager that may play at the same time, at most MIXER_MAX_VOICES
+const int VOICE_BUDGET {16};
+// instances of one sound that may play at the same time, unless set otherwise for the sound
+const int VOICE_DEFAULT_INSTANCES {4};
+// distance in level pixels at which a positioned sound fades to silence
+const int VOICE_AUDIBLE_DISTANCE {640};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+/**
+ * @file EditJournal.hpp
+ * @brief This file contains the undo and redo history of the tile edits made to a level.
+ *
+ * Instead of snapshots the journal keeps, per transaction, only the cells
+ * that changed: spans of consecutive cells in a row with their old and new
+ * ids run length encoded. Every write made while a transaction is open is
+ * gathered first, and closing the transaction folds cells written several
+ * times into one change, so a brush stroke costs memory for the cells it
+ * changed and undoing it costs time for the same cells.
+ */
+#ifndef EDIT_JOURNAL_HPP
+#define EDIT_JOURNAL_HPP
+
+#include <deque>
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/**
+ * @brief Undo and redo history of a TileMap, see TileMap::SetJournal().
+ */
+class EditJournal {
+public:
+
+    /**
+     * Constructor
+     * @param maxBytes Memory the history may use before the oldest transactions are dropped.
+     */
+    EditJournal(size_t maxBytes = EDIT_JOURNAL_MAX_BYTES);
+
+    /**
+     * Destructor
+     */
+    ~EditJournal();
+
+    /**
+     * Start gathering edits into a transaction, e.g. when a brush stroke starts.
+     * Does nothing if one is already open.
+     */
+    void BeginTransaction();
+
+    /**
+     * Close the open transaction and make it the next one to undo. A
+     * transaction that changed nothing is dropped. Clears the redo history.
+     */
+    void EndTransaction();
+
+    /// Whether a transaction is open, i.e. edits are being recorded.
+    bool IsRecording() const { return recording; }
+
+    /**
+     * Note a write to a run of cells of one row. Called by the map.
+     * @param mapWidth Width of the map, to number the cells.
+     * @param x Tile column of the first cell.
+     * @param y Tile row.
+     * @param oldIds The ids before the write.
+     * @param newIds The ids after the write.
+     * @param count Number of cells.
+     */
+    void Record(int mapWidth, int x, int y, const TileID *oldIds, const TileID *newIds, int count);
+
+    /// Whether there is a transaction to undo.
+    bool CanUndo() const { return !undoEntries.empty(); }
+    /// Whether there is a transaction to redo.
+    bool CanRedo() const { return !redoEntries.empty(); }
+
+    /**
+     * Put the cells of the last transaction back to their old ids. An open
+     * transaction is closed first and reopened afterwards, so the rest of a
+     * stroke that is still being drawn is recorded as a transaction of its own.
+     * @param map The map the transaction was recorded from.
+     * @return Whether there was anything to undo.
+     */
+    bool Undo(TileMap &map);
+
+    /**
+     * Apply the last undone transaction again. Like Undo(), splits an open transaction.
+     * @param map The map the transaction was recorded from.
+     * @return Whether there was anything to redo.
+     */
+    bool Redo(TileMap &map);
+
+    /**
+     * Forget the whole history and any open transaction, e.g. when a new level is loaded.
+     */
+    void Clear();
+
+    /// Bytes held by the undo and redo history.
+    size_t GetMemoryUsage() const { return usedBytes; }
+
+private:
+    /// A run of identical ids inside a span.
+    struct IdRun {
+        TileID id;
+        Uint16 length;
+    };
+
+    /// Consecutive changed cells of one row.
+    struct Span {
+        /// Index of the first cell, row * width + column.
+        Uint32 firstCell;
+        Uint32 count;
+        /// First run of the span in oldRuns and newRuns, the next span's are the end.
+        Uint32 firstOldRun;
+        Uint32 firstNewRun;
+    };
+
+    /// One undoable transaction.
+    struct Entry {
+        std::vector<Span> spans;
+        std::vector<IdRun> oldRuns;
+        std::vector<IdRun> newRuns;
+        /// Bytes held by the vectors above.
+        size_t bytes;
+    };
+
+    /// A single cell write gathered by the open transaction.
+    struct CellChange {
+        Uint32 cell;
+        TileID oldId;
+        TileID newId;
+    };
+
+    /// Write the old or new ids of a transaction into the map.
+    void Apply(TileMap &map, const Entry &entry, bool useNew);
+
+    /// Drop the oldest transactions until the history fits in maxBytes.
+    void Trim();
+
+    /// Drop the redo history.
+    void ClearRedo();
+
+    /// Memory limit of the history.
+    size_t maxBytes;
+    /// Bytes held by undoEntries and redoEntries.
+    size_t usedBytes;
+    /// Width of the map the history was recorded from.
+    int width;
+    /// Whether a transaction is open.
+    bool recording;
+    /// The writes of the open transaction in the order they were made.
+    std::vector<CellChange> pending;
+    /// Oldest first.
+    std::deque<Entry> undoEntries;
+    /// Most recently undone last.
+    std::vector<Entry> redoEntries;
+    /// Ids of one span while it is being applied.
+    std::vector<TileID> spanIds;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file InputLatency.hpp
+ * @brief This file contains the histogram of the delay between input and the frame that shows it.
+ *
+ * SDL stamps every event with the time it was queued. The program hands
+ * the timestamps of the events it reacts to to OnEvent(), and calls
+ * OnPresent() right after SDL_RenderPresent(). Each pending event then
+ * adds its delay until that present to a histogram of one millisecond
+ * buckets, from which percentiles can be read at any time.
+ */
+#ifndef INPUT_LATENCY_HPP
+#define INPUT_LATENCY_HPP
+
+#include <array>
+#include <ostream>
+#include <vector>
+#include "Config.hpp"
+
+/**
+ * @brief Measures input to present latency.
+ */
+class InputLatency {
+public:
+
+    /**
+     * Constructor
+     */
+    InputLatency();
+
+    /**
+     * Destructor
+     */
+    ~InputLatency();
+
+    /**
+     * Remember an event that the next presented frame reflects.
+     * @param timestamp The timestamp of the SDL_Event, in SDL_GetTicks() milliseconds.
+     */
+    void OnEvent(Uint32 timestamp);
+
+    /**
+     * Count the delay of every remembered event until now.
+     * @param now SDL_GetTicks() right after SDL_RenderPresent().
+     */
+    void OnPresent(Uint32 now);
+
+    /**
+     * Forget the events remembered since the last present without measuring
+     * them, e.g. at the end of a loop that did not present a frame.
+     */
+    void ClearPending() { pending.clear(); }
+
+    /// Number of events measured.
+    Uint64 GetCount() const { return count; }
+
+    /**
+     * @param fraction From 0 to 1, e.g. 0.99 for the 99th percentile.
+     * @return The latency in milliseconds that this fraction of events stayed within, 0 if nothing was measured.
+     */
+    int GetPercentile(double fraction) const;
+
+    /**
+     * Forget everything measured so far.
+     */
+    void Reset();
+
+    /**
+     * Print the percentiles and the non-empty buckets of the histogram.
+     */
+    void Report(std::ostream &out) const;
+
+private:
+    /// Timestamps of the events since the last present.
+    std::vector<Uint32> pending;
+    /// Events by latency in milliseconds, the last bucket holds everything longer.
+    std::array<Uint64, INPUT_LATENCY_MAX_MS + 1> buckets;
+    /// Number of events measured.
+    Uint64 count;
+};
+
+#endif
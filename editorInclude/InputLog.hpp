@@ -0,0 +1,179 @@
+/**
+ * @file InputLog.hpp
+ * @brief This file contains the recording and replay of the input of an editor session.
+ *
+ * The recorder writes every input event the editor reacts to, together with
+ * the fixed update tick it was applied before, to a compact binary log. The
+ * replayer hands the same events back at the same ticks, so a replayed
+ * session makes exactly the same edits as the recorded one, however fast or
+ * slow the frames of the replay are. The log ends with the number of ticks
+ * the session ran and a checksum of the level at that point, which a replay
+ * can compare against to catch changes in behaviour.
+ *
+ * Layout, multi-byte fields little endian:
+ *
+ *   InputLogHeader
+ *   records, each made of
+ *     varint ticks since the previous record
+ *     byte INPUT_RECORD_TYPE
+ *     payload:
+ *       INPUT_KEY_DOWN     varint key symbol, varint key modifiers
+ *       INPUT_MOUSE_DOWN,
+ *       INPUT_MOUSE_UP     byte button, zigzag varint x, zigzag varint y
+ *       INPUT_MOUSE_MOTION varint button state, zigzag varint x, zigzag varint y
+ *       INPUT_END          Uint32 level checksum, the tick is the last tick of the session
+ *
+ * Varints store 7 bits per byte, lowest first, with the top bit set on all
+ * bytes but the last. Most records take four to six bytes.
+ */
+#ifndef INPUT_LOG_HPP
+#define INPUT_LOG_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Config.hpp"
+
+/// The first four bytes of every input log.
+const char INPUT_LOG_MAGIC[4] = {'L', 'V', 'I', 'N'};
+/// The format version this build reads and writes.
+const Uint32 INPUT_LOG_VERSION {1};
+
+/// Kinds of records in an input log.
+enum INPUT_RECORD_TYPE {
+    INPUT_KEY_DOWN = 1,
+    INPUT_MOUSE_DOWN,
+    INPUT_MOUSE_UP,
+    INPUT_MOUSE_MOTION,
+    INPUT_END
+};
+
+/// The fixed size block at the start of an input log.
+struct InputLogHeader {
+    char magic[4];
+    Uint32 version;
+    /// Fixed updates per second of the recorded session.
+    Uint32 updatesPerSecond;
+};
+
+static_assert(sizeof(InputLogHeader) == 12, "InputLogHeader layout is part of the file format");
+
+/**
+ * @brief Writes the input of a session to an input log.
+ */
+class InputRecorder {
+public:
+
+    /**
+     * Constructor
+     */
+    InputRecorder();
+
+    /**
+     * Destructor. Closes the log without an end record if it is still open.
+     */
+    ~InputRecorder();
+
+    /**
+     * Create a log, replacing any file of the same name.
+     * @return Whether the file could be created.
+     */
+    bool Open(const std::string &logPath);
+
+    /// Whether input is being recorded.
+    bool IsOpen() const { return file != nullptr; }
+
+    /**
+     * Record an event, if it is one the log keeps.
+     * @param tick The update tick the event is applied before.
+     * @param event The event.
+     */
+    void Record(Uint32 tick, const SDL_Event &event);
+
+    /**
+     * Write the end record and close the log.
+     * @param tick The number of ticks the session ran.
+     * @param levelChecksum A checksum of the level after the last tick.
+     * @return Whether the whole log was written.
+     */
+    bool Close(Uint32 tick, Uint32 levelChecksum);
+
+    /// Whether an event is one the log keeps.
+    static bool IsRecorded(const SDL_Event &event);
+
+private:
+    /// Append the tick delta and type of a record to the buffer.
+    void BeginRecord(Uint32 tick, INPUT_RECORD_TYPE type);
+
+    /// The log being written.
+    FILE *file;
+    /// Tick of the previous record.
+    Uint32 lastTick;
+    /// Bytes of the current record, reused between records.
+    std::vector<Uint8> record;
+};
+
+/**
+ * @brief Reads an input log back event by event.
+ */
+class InputReplayer {
+public:
+
+    /**
+     * Constructor
+     */
+    InputReplayer();
+
+    /**
+     * Destructor
+     */
+    ~InputReplayer();
+
+    /**
+     * Read a whole log into memory.
+     * @return Whether it is an input log this build can read.
+     */
+    bool Open(const std::string &logPath);
+
+    /// Whether a log is being replayed.
+    bool IsOpen() const { return open; }
+
+    /**
+     * The next event of a tick.
+     * @param tick The update tick about to run.
+     * @param event Receives the event, stamped with the current time.
+     * @return false once every event of the tick was returned.
+     */
+    bool Next(Uint32 tick, SDL_Event &event);
+
+    /// Whether the replay reached the end of the recorded session at a tick.
+    bool IsFinished(Uint32 tick) const;
+
+    /// Fixed updates per second of the recorded session.
+    Uint32 GetUpdatesPerSecond() const { return updatesPerSecond; }
+
+    /// Whether the log has an end record, i.e. the recording was closed properly.
+    bool HasEnd() const { return hasEnd; }
+
+    /// The level checksum of the end record.
+    Uint32 GetLevelChecksum() const { return levelChecksum; }
+
+private:
+    /// The whole log.
+    std::vector<Uint8> data;
+    /// Read position in data.
+    size_t position;
+    /// End of the well formed records, a log cut short by a crash ends early.
+    size_t validEnd;
+    /// Tick of the last record returned.
+    Uint32 lastTick;
+    /// Whether a log is open.
+    bool open;
+    /// Values of the header and of the end record.
+    Uint32 updatesPerSecond;
+    bool hasEnd;
+    Uint32 endTick;
+    Uint32 levelChecksum;
+};
+
+#endif
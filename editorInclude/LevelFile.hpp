@@ -0,0 +1,202 @@
+/**
+ * @file LevelFile.hpp
+ * @brief This file contains the binary level format and its memory mapped reader.
+ *
+ * Layout, all fields little endian:
+ *   - LevelFileHeader
+ *   - chunk payloads, each starting on an 8 byte boundary
+ *   - one LevelChunkEntry per chunk, row by row, at chunkTableOffset
+ *
+ * A raw chunk stores chunkSize * chunkSize 16 bit tile ids row by row, padded
+ * with EMPTY_TILE past the map edge, so it can be read straight out of the
+ * mapping. An RLE chunk stores (count, id) pairs of 16 bit values. An empty
+ * chunk stores nothing at all.
+ */
+#ifndef LEVEL_FILE_HPP
+#define LEVEL_FILE_HPP
+
+#include <functional>
+#include <string>
+#include "Config.hpp"
+#include "MappedFile.hpp"
+#include "TileMap.hpp"
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    #error "The binary level format is read in place and assumes a little endian host"
+#endif
+
+/// The first four bytes of every binary level.
+const char LEVEL_FILE_MAGIC[4] = {'L', 'V', 'L', 'B'};
+/// The newest format version this build reads and the one it writes.
+const Uint16 LEVEL_FILE_VERSION {1};
+/// Largest chunk side a binary level may declare.
+const Uint32 LEVEL_MAX_CHUNK_SIZE {256};
+/// Largest width or height, in tiles, a binary level may declare.
+const Uint32 LEVEL_MAX_SIDE {1 << 20};
+/// Most TILE_CHUNK_SIZE chunks a level may need once loaded, which keeps TileMap's chunk counts in an int.
+const Uint64 LEVEL_MAX_MAP_CHUNKS {1 << 22};
+
+/// How the tiles of one chunk are stored.
+enum LEVEL_CHUNK_ENCODING {
+    CHUNK_EMPTY = 0,
+    CHUNK_RAW,
+    CHUNK_RLE
+};
+
+/// The fixed size block at the start of a binary level.
+struct LevelFileHeader {
+    char magic[4];
+    Uint16 version;
+    /// Tiles along each side of a chunk.
+    Uint16 chunkSize;
+    Uint32 width;
+    Uint32 height;
+    Uint32 chunkCount;
+    Uint32 reserved;
+    /// Byte offset of the chunk table from the start of the file.
+    Uint64 chunkTableOffset;
+};
+
+/// Where one chunk's payload lives in the file.
+struct LevelChunkEntry {
+    /// Byte offset of the payload from the start of the file.
+    Uint64 offset;
+    /// Payload size in bytes.
+    Uint32 size;
+    /// One of LEVEL_CHUNK_ENCODING.
+    Uint16 encoding;
+    Uint16 reserved;
+};
+
+static_assert(sizeof(LevelFileHeader) == 32, "LevelFileHeader layout is part of the file format");
+static_assert(sizeof(LevelChunkEntry) == 16, "LevelChunkEntry layout is part of the file format");
+
+/**
+ * @brief A binary level mapped into memory and read in place.
+ */
+class LevelFile {
+public:
+
+    /**
+     * Constructor
+     */
+    LevelFile();
+
+    /**
+     * Destructor
+     */
+    ~LevelFile();
+
+    /**
+     * Map a binary level and check its header and chunk table.
+     * @param filePath The file name of the binary level.
+     * @return Whether the file is a valid binary level this build can read.
+     */
+    bool Open(const std::string &filePath);
+
+    /**
+     * Unmap the level.
+     */
+    void Close();
+
+    /// Number of tile columns.
+    int GetWidth() const { return header ? (int)header->width : 0; }
+    /// Number of tile rows.
+    int GetHeight() const { return header ? (int)header->height : 0; }
+    /// Tiles along each side of a chunk.
+    int GetChunkSize() const { return header ? header->chunkSize : 0; }
+    /// Number of chunk columns.
+    int GetChunkCols() const { return chunkCols; }
+    /// Number of chunk rows.
+    int GetChunkRows() const { return chunkRows; }
+
+    /**
+     * @return One of LEVEL_CHUNK_ENCODING.
+     */
+    int GetChunkEncoding(int chunkX, int chunkY) const;
+
+    /**
+     * @return The tiles of a raw chunk, pointing into the mapping, or nullptr if the chunk is not raw.
+     */
+    const TileID *GetRawChunk(int chunkX, int chunkY) const;
+
+    /**
+     * Decode any chunk into chunkSize * chunkSize tile ids.
+     * @param out Receives the tiles row by row.
+     * @return Whether the chunk payload was valid.
+     */
+    bool DecodeChunk(int chunkX, int chunkY, TileID *out) const;
+
+    /**
+     * Read a single tile. Raw and empty chunks answer in place, RLE chunks are scanned.
+     * @return The tile id, or EMPTY_TILE outside of the map.
+     */
+    TileID GetTile(int x, int y) const;
+
+    /**
+     * Copy the whole level into a tile map.
+     * @param map Resized to the level's size.
+     * @return Whether every chunk could be decoded.
+     */
+    bool CopyTo(TileMap &map) const;
+
+    /**
+     * @param filePath Any file.
+     * @return Whether the file starts with LEVEL_FILE_MAGIC.
+     */
+    static bool IsLevelFile(const std::string &filePath);
+
+    /**
+     * Write a tile map as a binary level.
+     * @param map The map to write.
+     * @param filePath The file name of the binary level.
+     * @param compress Store chunks as RLE wherever that is smaller than raw.
+     * @return Whether the file was written.
+     */
+    static bool Write(const TileMap &map, const std::string &filePath, bool compress);
+
+    /**
+     * Fills out with the TILE_CHUNK_SIZE * TILE_CHUNK_SIZE tiles of a chunk row
+     * by row, EMPTY_TILE past the map edge. Returns whether it could.
+     */
+    typedef std::function<bool(int chunkX, int chunkY, TileID *out)> ChunkSource;
+
+    /**
+     * Write a binary level one chunk at a time, so the level never has to be
+     * in memory as a whole.
+     * @param width Number of tile columns.
+     * @param height Number of tile rows.
+     * @param readChunk Called once for every chunk, row by row.
+     * @param filePath The file name of the binary level.
+     * @param compress Store chunks as RLE wherever that is smaller than raw.
+     * @return Whether every chunk was read and the file was written.
+     */
+    static bool Write(int width, int height, const ChunkSource &readChunk, const std::string &filePath, bool compress);
+
+    /**
+     * Convert a level between the text and binary formats. The output uses
+     * whichever format the input does not.
+     * @param inputPath The level to read.
+     * @param outputPath The level to write.
+     * @param compress Use RLE chunks when writing a binary level.
+     * @return Whether the level was converted.
+     */
+    static bool Convert(const std::string &inputPath, const std::string &outputPath, bool compress);
+
+private:
+    /// The chunk table entry, or nullptr outside of the map.
+    const LevelChunkEntry *GetEntry(int chunkX, int chunkY) const;
+
+    /// The mapped file.
+    MappedFile file;
+    /// The header, pointing into the mapping.
+    const LevelFileHeader *header;
+    /// The chunk table, pointing into the mapping.
+    const LevelChunkEntry *chunkTable;
+    /// Number of chunk columns.
+    int chunkCols;
+    /// Number of chunk rows.
+    int chunkRows;
+};
+
+#endif
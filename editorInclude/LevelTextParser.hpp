@@ -0,0 +1,83 @@
+/**
+ * @file LevelTextParser.hpp
+ * @brief This file contains the loader for text levels.
+ *
+ * The file is memory mapped and parsed in place with std::from_chars. Finding
+ * the rows and parsing them are both split across threads: each thread takes
+ * a contiguous range of the file or of the rows, so no thread waits on another
+ * until the results are merged.
+ */
+#ifndef LEVEL_TEXT_PARSER_HPP
+#define LEVEL_TEXT_PARSER_HPP
+
+#include <string>
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/// A problem found on one line of a text level.
+struct LevelParseError {
+    /// Line number in the file, starting at 1.
+    int line;
+    /// What is wrong with the line.
+    std::string message;
+};
+
+/**
+ * @brief Parses whitespace separated tile ids, one row per line, blank lines ignored.
+ *
+ * The widest row sets the width of the map and shorter rows are padded with
+ * EMPTY_TILE. Tokens that are not tile ids are reported.
+ */
+class LevelTextParser {
+public:
+
+    /**
+     * Constructor
+     */
+    LevelTextParser();
+
+    /**
+     * Destructor
+     */
+    ~LevelTextParser();
+
+    /**
+     * @param threads Number of threads to parse with, 0 picks one per core.
+     */
+    void SetThreadCount(int threads);
+
+    /**
+     * Map a text level and parse it.
+     * @param filePath The file name of the level file.
+     * @param map Receives the level. It is left untouched if the file cannot be opened.
+     * @return Whether the file was opened and every row was valid.
+     */
+    bool ParseFile(const std::string &filePath, TileMap &map);
+
+    /**
+     * Parse a text level that is already in memory.
+     * @param data The first character of the level.
+     * @param size Number of characters.
+     * @param map Receives the level. Invalid tokens are read as EMPTY_TILE.
+     * @return Whether every row was valid.
+     */
+    bool Parse(const char *data, size_t size, TileMap &map);
+
+    /**
+     * @return The problems found by the last parse, ordered by line.
+     */
+    const std::vector<LevelParseError> &GetErrors() const { return errors; }
+
+private:
+    /// Number of threads to use for size characters of input.
+    int ThreadsFor(size_t size) const;
+
+    /// Number of threads requested, 0 for one per core.
+    int threadCount;
+
+    /// The problems found by the last parse.
+    std::vector<LevelParseError> errors;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file MappedFile.hpp
+ * @brief This file contains a read-only memory mapping of a whole file.
+ *
+ * The operating system pages the file in on demand, so the contents can be
+ * used in place without reading them into a separate buffer first.
+ */
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <stddef.h>
+
+/**
+ * @brief A read-only view of a file's bytes, unmapped when the object goes away.
+ */
+class MappedFile {
+public:
+
+    /**
+     * Constructor
+     */
+    MappedFile();
+
+    /**
+     * Destructor
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map a file, closing any file mapped before.
+     * @param filePath The file name of the file to map.
+     * @return Whether the file was mapped. Empty files map to a null view of size 0.
+     */
+    bool Open(const std::string &filePath);
+
+    /**
+     * Unmap the file.
+     */
+    void Close();
+
+    /// Whether a file is currently mapped.
+    bool IsOpen() const { return open; }
+
+    /// The first byte of the file.
+    const char *Data() const { return data; }
+
+    /// The size of the file in bytes.
+    size_t Size() const { return size; }
+
+private:
+    /// Whether a file is currently mapped.
+    bool open;
+    /// The first byte of the mapping.
+    const char *data;
+    /// The size of the mapping in bytes.
+    size_t size;
+#ifdef _WIN32
+    /// The file mapping object backing the view.
+    void *mappingHandle;
+#endif
+};
+
+#endif
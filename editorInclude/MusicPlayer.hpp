@@ -0,0 +1,66 @@
+/**
+ * @file MusicPlayer.hpp
+ * @brief This file contains the player of the background music.
+ *
+ * The music is never decoded as a whole. SDL_mixer keeps the file open and
+ * its decoder reads and decodes the next few kilobytes each time the audio
+ * device asks for samples, on SDL's audio thread. The main thread only
+ * starts, pauses and stops playback, so the music costs it no time per
+ * frame and only the decoder state and the device buffers stay in memory,
+ * instead of the minutes of PCM a fully decoded song would take.
+ */
+#ifndef MUSIC_PLAYER_HPP
+#define MUSIC_PLAYER_HPP
+
+#include <SDL_mixer.h>
+#include "Config.hpp"
+
+/**
+ * @brief Streams one piece of music from disk. The audio device must be open.
+ */
+class MusicPlayer {
+public:
+
+    /**
+     * Constructor
+     */
+    MusicPlayer();
+
+    /**
+     * Destructor
+     */
+    ~MusicPlayer();
+
+    /**
+     * Open a music file and start playing it, replacing the music played before.
+     * @param musicPath The file name of the music, e.g. an MP3 or OGG file.
+     * @param loops How often to play it, -1 to loop until Stop().
+     * @return Whether playback started.
+     */
+    bool Play(const char *const musicPath, int loops = -1);
+
+    /**
+     * Set the volume of the music.
+     * @param volume From 0, silent, to 1, full volume.
+     */
+    void SetVolume(double volume);
+
+    /**
+     * Pause the music if it is playing and resume it if it is paused.
+     */
+    void TogglePause();
+
+    /// Whether music is playing, paused or not.
+    bool IsPlaying() const;
+
+    /**
+     * Stop playback and close the music file.
+     */
+    void Stop();
+
+private:
+    /// The music being played, streamed from its file.
+    Mix_Music *music;
+};
+
+#endif
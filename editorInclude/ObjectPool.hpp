@@ -0,0 +1,165 @@
+/**
+ * @file ObjectPool.hpp
+ * @brief This file contains a pool of objects of one type in one contiguous block of memory.
+ *
+ * The pool allocates storage for all of its objects when it is created and
+ * never again. Acquire() constructs an object in a free slot and Release()
+ * destroys it and frees the slot, both in constant time through a stack of
+ * free slot indices. Objects that are spawned and despawned at a high rate
+ * then cost no trip to the heap, do not fragment it and sit next to each
+ * other in memory when they are updated.
+ *
+ * With poisoning on, a released slot is filled with POOL_POISON_BYTE and
+ * checked when it is acquired again, which catches writes through pointers
+ * that outlived their object. Releasing a pointer twice, or one that is not
+ * from the pool, is reported whether poisoning is on or not.
+ */
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "Config.hpp"
+
+/// Fills the slots of released objects when a pool poisons them.
+const Uint8 POOL_POISON_BYTE {0xDD};
+
+/**
+ * @brief Fixed number of objects of type T with constant time acquire and release.
+ * @tparam T The object type.
+ */
+template <typename T>
+class ObjectPool {
+public:
+
+    /**
+     * Constructor. Allocates the storage of every object, constructs none.
+     * @param capacity Most objects alive at once.
+     * @param poison Whether to poison released slots, for debugging.
+     */
+    explicit ObjectPool(size_t capacity, bool poison = false)
+        : slots(new Slot[capacity]), inUse(capacity, 0), capacity(capacity), liveCount(0), peakCount(0), poison(poison) {
+        freeSlots.reserve(capacity);
+        // the first acquires take the first slots
+        for (size_t i = capacity; i > 0; i--) freeSlots.push_back((Uint32)(i - 1));
+        if (poison) memset(slots.get(), POOL_POISON_BYTE, capacity * sizeof(Slot));
+    }
+
+    /**
+     * Destructor. Destroys the objects still alive.
+     */
+    ~ObjectPool() {
+        Clear();
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool &operator=(const ObjectPool&) = delete;
+
+    /**
+     * Construct an object in a free slot.
+     * @param args The arguments of T's constructor.
+     * @return The object, or nullptr if every slot is in use.
+     */
+    template <typename... Args>
+    T *Acquire(Args&&... args) {
+        if (freeSlots.empty()) return nullptr;
+        Uint32 index = freeSlots.back();
+        freeSlots.pop_back();
+        if (poison && !IsPoisoned(index)) {
+            SDL_Log("Object pool slot %u was written to after its object was released", index);
+        }
+        T *object = new (&slots[index]) T(std::forward<Args>(args)...);
+        inUse[index] = 1;
+        liveCount++;
+        if (liveCount > peakCount) peakCount = liveCount;
+        return object;
+    }
+
+    /**
+     * Destroy an object and free its slot.
+     * @param object An object acquired from this pool and not released since.
+     * @return false, changing nothing, if the object is not a live object of this pool.
+     */
+    bool Release(T *object) {
+        size_t index;
+        if (!IndexOf(object, index) || !inUse[index]) {
+            SDL_Log("Object pool asked to release %p, which is not one of its live objects", (void*)object);
+            return false;
+        }
+        object->~T();
+        if (poison) memset(&slots[index], POOL_POISON_BYTE, sizeof(Slot));
+        inUse[index] = 0;
+        freeSlots.push_back((Uint32)index);
+        liveCount--;
+        return true;
+    }
+
+    /**
+     * Destroy every live object.
+     */
+    void Clear() {
+        for (size_t i = 0; i < capacity; i++) {
+            if (inUse[i]) Release(reinterpret_cast<T*>(&slots[i]));
+        }
+    }
+
+    /**
+     * Call function(T&) on every live object, in the order of their slots.
+     */
+    template <typename Function>
+    void ForEach(Function function) {
+        for (size_t i = 0; i < capacity; i++) {
+            if (inUse[i]) function(*reinterpret_cast<T*>(&slots[i]));
+        }
+    }
+
+    /// Objects alive now.
+    size_t GetLiveCount() const { return liveCount; }
+
+    /// The most objects that were alive at once.
+    size_t GetPeakCount() const { return peakCount; }
+
+    /// Most objects alive at once.
+    size_t GetCapacity() const { return capacity; }
+
+private:
+    /// Storage of one object.
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    /// Find the slot of a pointer, false if it does not point at the start of one.
+    bool IndexOf(const T *object, size_t &index) const {
+        uintptr_t base = (uintptr_t)slots.get(), address = (uintptr_t)object;
+        if (address < base || address - base >= capacity * sizeof(Slot)) return false;
+        if ((address - base) % sizeof(Slot) != 0) return false;
+        index = (address - base) / sizeof(Slot);
+        return true;
+    }
+
+    /// Whether a free slot still holds nothing but the poison pattern.
+    bool IsPoisoned(size_t index) const {
+        const unsigned char *bytes = slots[index].bytes;
+        for (size_t i = 0; i < sizeof(Slot); i++) {
+            if (bytes[i] != POOL_POISON_BYTE) return false;
+        }
+        return true;
+    }
+
+    /// Every slot, contiguous.
+    std::unique_ptr<Slot[]> slots;
+    /// Whether a slot holds a live object.
+    std::vector<Uint8> inUse;
+    /// Indices of the free slots, the next one to use last.
+    std::vector<Uint32> freeSlots;
+    size_t capacity;
+    size_t liveCount;
+    size_t peakCount;
+    bool poison;
+};
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file PerfOverlay.hpp
+ * @brief This file contains the overlay that shows live performance numbers in the window.
+ *
+ * The overlay keeps the frame times of the last PERF_GRAPH_FRAMES frames in
+ * a ring and draws them as a scrolling graph, under a few lines of text
+ * with the time split between update and render, the update steps of the
+ * last frame, draw calls, texture memory and input to present latency.
+ *
+ * Drawing the overlay must not disturb what it measures, so it allocates
+ * nothing per frame: the ring, the graph bars and the text buffer are
+ * members of fixed size, all bars go out in one SDL_RenderFillRects call
+ * and all text in one batch of the glyph atlas.
+ */
+#ifndef PERF_OVERLAY_HPP
+#define PERF_OVERLAY_HPP
+
+#include <array>
+#include "Config.hpp"
+#include "RenderStats.hpp"
+#include "InputLatency.hpp"
+#include "TextRenderer.hpp"
+
+/**
+ * @brief Draws a frame time graph and frame statistics over the level.
+ */
+class PerfOverlay {
+public:
+
+    /**
+     * Constructor
+     */
+    PerfOverlay();
+
+    /**
+     * Destructor
+     */
+    ~PerfOverlay();
+
+    /**
+     * Add the timings of a finished frame.
+     * @param frameMs Time of the whole frame in milliseconds.
+     * @param updateMs Time spent updating the scene.
+     * @param renderMs Time spent rendering it.
+     * @param updateSteps Number of fixed updates the frame ran.
+     */
+    void RecordFrame(double frameMs, double updateMs, double renderMs, int updateSteps);
+
+    /**
+     * Set where the input latency shown comes from.
+     * @param latency The measurements, they must outlive this overlay or be replaced.
+     */
+    void SetInputLatency(const InputLatency *latency) { inputLatency = latency; }
+
+    /**
+     * Draw the overlay if it is visible.
+     * @param ren Reference to SDL renderer.
+     * @param text The renderer the text is drawn with.
+     * @param x Left edge of the overlay on screen.
+     * @param y Bottom edge of the overlay on screen.
+     */
+    void Render(SDL_Renderer *ren, TextRenderer &text, int x, int y);
+
+    /// Show the overlay if it is hidden and hide it if it is shown.
+    void Toggle() { visible = !visible; }
+
+    /// Whether the overlay is shown.
+    bool IsVisible() const { return visible; }
+
+private:
+    /// Frame times in milliseconds, the oldest at newestFrame + 1.
+    std::array<float, PERF_GRAPH_FRAMES> frameTimes;
+    /// Index of the newest frame time.
+    int newestFrame;
+    /// Timings of the last frame.
+    double updateMs;
+    double renderMs;
+    int updateSteps;
+    /// Input to present latency, nullptr if it is not measured.
+    const InputLatency *inputLatency;
+
+    /// One bar per frame time, filled in place every time the overlay is drawn.
+    std::array<SDL_Rect, PERF_GRAPH_FRAMES> bars;
+    /// The statistics as text, formatted in place.
+    char text[160];
+    /// Whether the overlay is shown.
+    bool visible;
+};
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file ProcessMemory.hpp
+ * @brief This file contains the memory use of the editor process as the operating system sees it.
+ *
+ * The peak is the largest resident set the process had so far, which for a
+ * long run also shows memory that grew and was freed again in between.
+ */
+#ifndef PROCESS_MEMORY_HPP
+#define PROCESS_MEMORY_HPP
+
+#include <cstddef>
+
+/**
+ * The most physical memory the process used at any time so far.
+ * @return The peak in bytes, or 0 if the platform does not report it.
+ */
+size_t GetPeakMemoryBytes();
+
+#endif
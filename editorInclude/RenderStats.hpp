@@ -0,0 +1,58 @@
+/**
+ * @file RenderStats.hpp
+ * @brief This file contains the counters of draw calls and texture memory shown by the performance overlay.
+ *
+ * SDL reports neither, so the code that issues draw calls or creates and
+ * destroys textures reports them here. The counters are only touched from
+ * the main thread, which owns the renderer.
+ */
+#ifndef RENDER_STATS_HPP
+#define RENDER_STATS_HPP
+
+#include "Config.hpp"
+
+/**
+ * @brief Draw calls per frame and the memory of all live textures.
+ */
+class RenderStats {
+public:
+
+    /**
+     * Count draw calls issued for the frame being rendered.
+     */
+    static void CountDrawCalls(int count = 1);
+
+    /**
+     * Count the memory of a texture that was just created. nullptr is ignored.
+     */
+    static void AddTexture(SDL_Texture *texture);
+
+    /**
+     * Stop counting the memory of a texture about to be destroyed. nullptr is ignored.
+     */
+    static void RemoveTexture(SDL_Texture *texture);
+
+    /**
+     * Finish the frame being rendered and start counting the next one.
+     */
+    static void EndFrame();
+
+    /// Draw calls of the last finished frame.
+    static int GetDrawCalls() { return lastDrawCalls; }
+
+    /// Estimated memory of all live textures in bytes, width * height * bytes per pixel.
+    static size_t GetTextureBytes() { return textureBytes; }
+
+private:
+    /// Estimated memory of a texture in bytes.
+    static size_t TextureBytes(SDL_Texture *texture);
+
+    /// Draw calls of the frame being rendered.
+    static int frameDrawCalls;
+    /// Draw calls of the last finished frame.
+    static int lastDrawCalls;
+    /// Estimated memory of all live textures.
+    static size_t textureBytes;
+};
+
+#endif
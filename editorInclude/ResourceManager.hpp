@@ -8,6 +8,9 @@
 #include <iterator>
 #include "Config.hpp"
 #include "Sprite.hpp"
+#include "Camera.hpp"
+#include "SpatialHash.hpp"
+#include "ObjectPool.hpp"
 
 // Just a cheap little class to demonstrate loading characters.
 class ResourceManager{
@@ -29,11 +32,27 @@ public:
 
 	void render(int id, SDL_Renderer* ren);
 
+	// show or hide a sprite in the level
+	void set_active(int id, bool active);
+
+	// render the active sprites the camera can see, found through the spatial hash
+	void render_visible(SDL_Renderer* ren, const Camera &camera);
+
+	// the active sprites that overlap, one from layers_a and one from layers_b,
+	// e.g. find_overlaps(LAYER_PLAYER, LAYER_ENEMY, hits)
+	void find_overlaps(Uint32 layers_a, Uint32 layers_b, std::vector<std::pair<int, int>> &out);
+
 
 private:
 	SDL_Renderer* renderer;
 	static ResourceManager *instance;
+	// the storage of every sprite, so loading and unloading sprites does not go through the heap
+	ObjectPool<Sprite> sprite_pool;
 	std::map<int, Sprite*> loaded_resources;
+	// the active sprites, filed by the area they cover
+	SpatialHash active_sprites;
+	// reused by render_visible() so culling does not allocate every frame
+	std::vector<int> visible_ids;
 };
 
 #endif
@@ -15,44 +15,140 @@
 //
 #include "Config.hpp"
 #include "ResourceManager.hpp"
+#include "TileMap.hpp"
+#include "TileMapRenderer.hpp"
+#include "ChunkStreamer.hpp"
+#include "Camera.hpp"
+#include "CollisionMap.hpp"
+#include "Autotiler.hpp"
+#include "EditJournal.hpp"
+#include "TileFill.hpp"
+#include "Autosaver.hpp"
+#include "TextRenderer.hpp"
+#include "PerfOverlay.hpp"
+#include "MusicPlayer.hpp"
+#include "AudioMixer.hpp"
+#include "VoiceManager.hpp"
+#include "InputLatency.hpp"
+#include "InputLog.hpp"
+#include "ProcessMemory.hpp"
+#include "Arena.hpp"
 
 
 
+// How the editor is run, set from the command line
+struct RunOptions {
+    // record the input of the session to this log, if not empty
+    std::string recordPath;
+    // play this input log back instead of reading live input, if not empty
+    std::string replayPath;
+    // run without a visible window, audio or rendering
+    bool headless = false;
+    // run one update per loop iteration as fast as possible instead of at the fixed rate
+    bool uncapped = false;
+    // run this many updates as fast as possible, then report the throughput and quit, if above 0
+    int fastForwardTicks = 0;
+    // while fast-forwarding, render after every this many updates, never if 0
+    int renderEvery = 0;
+    // delete the autosave of the level and start from the level on disk
+    bool discardAutosave = false;
+};
+
 //const char* SPRITE_PATH = "./sprite.bmp";
 // This class sets up a full graphics program
 class SDLGraphicsProgram{
 public:
 
     // Constructor
-    SDLGraphicsProgram(int w, int h);
+    SDLGraphicsProgram(int w, int h, const RunOptions &options = RunOptions());
     // Desctructor
     ~SDLGraphicsProgram();
     // Per frame update
     void update();
     // the Update() helper function that provide a frame stablizer
+    // input is processed in here, right before the last update of the frame
     void update_with_timer(std::chrono::steady_clock::time_point &previous_time,
                     double &elapsed_time_total, int &frame_counter, 
-                    double &lag, double mcs_per_update);
+                    double &lag, double mcs_per_update, bool *quit);
     // Renders shapes to the screen
     void render();
     // loop that runs forever
     void loop();
+    // run options.fastForwardTicks updates back to back and report how fast they ran
+    void fastForward(bool *quit);
     void destroy();
     // Get Pointer to Window
     SDL_Window* getSDLWindow();
     // Get Pointer to Renderer
     SDL_Renderer* getSDLRenderer();
     void promptMsg();
+    // draw the sprite menu over the level
+    void renderMenu();
+    // read the live events, or only the quit events when a log is replayed
     void processInput(bool *quit);
+    // apply one input event, recorded or replayed, to the editor
+    void handleEvent(const SDL_Event &event, bool *quit);
+    // a checksum of every tile of the level, to compare replays against their recording
+    Uint32 levelChecksum() const;
+    // paint or erase terrain under a point of the window
+    void paintTerrain(int screenX, int screenY, bool terrain);
+    // fill the region under the mouse with terrain
+    void fillTerrain();
 private:
     // Screen dimension constants
     int screenHeight;
     int screenWidth;
     int spriteID = 0;
+    // How the editor was started
+    RunOptions options;
+    // Fixed updates run so far, the clock input is recorded and replayed against
+    Uint32 tickCount = 0;
+    // Last mouse position the input events reported, in window pixels
+    int mouseX = 0;
+    int mouseY = 0;
+    // Writes the input of the session when recording
+    InputRecorder recorder;
+    // Feeds a recorded session back in when replaying
+    InputReplayer replayer;
     // The window we'll be rendering to
     SDL_Window* gWindow ;
     // SDL Renderer
     SDL_Renderer* gRenderer = NULL;
+    // The part of the level shown in the window
+    Camera camera;
+    // The level currently being shown
+    TileMap tileMap;
+    // Draws the level through baked chunk textures
+    TileMapRenderer tileMapRenderer;
+    // Pages the chunks of a binary level in and out around the view
+    ChunkStreamer chunkStreamer;
+    // Which tiles of the level are solid, for collision queries
+    CollisionMap collisionMap;
+    // Picks edge and corner tiles for the terrain painted with the mouse
+    Autotiler autotiler;
+    // Undo and redo history of the painted terrain, one transaction per stroke
+    EditJournal journal;
+    // Writes the edited chunks to disk in the background
+    Autosaver autosaver;
+    // Draws on-screen text from a glyph atlas
+    TextRenderer textRenderer;
+    // Whether the whole sprite menu is shown or only the selected sprite
+    bool showMenu = false;
+    // Frame time graph and frame statistics, toggled with p
+    PerfOverlay perfOverlay;
+    // Number of fixed updates update_with_timer ran in the current frame
+    int updateSteps = 0;
+    // Streams the background music, toggled with b
+    MusicPlayer musicPlayer;
+    // Plays sound effects on the audio thread, on top of the music
+    AudioMixer audioMixer;
+    // Decides which of the triggered sound effects get one of the mixer's voices
+    VoiceManager voiceManager;
+    // Delay from input events to the present that shows them
+    InputLatency inputLatency;
+    // Clicks played when a paint stroke starts and when a region is filled
+    SoundID paintSound = -1;
+    SoundID fillSound = -1;
 };
 
 //const int frame_rate {30};
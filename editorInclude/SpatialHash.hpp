@@ -0,0 +1,132 @@
+/**
+ * @file SpatialHash.hpp
+ * @brief This file contains a uniform grid that finds the entities inside an area.
+ *
+ * Every entity is filed under each grid cell its bounding box overlaps. Cells
+ * are kept in a hash map, so only cells that hold something take memory and
+ * the level can be of any size. An area query looks at the cells the area
+ * overlaps and nothing else.
+ *
+ * Moving an entity only touches the cells it enters or leaves, and pair
+ * generation only compares entities that share a cell, so both cost about
+ * linear time in the number of entities as long as they are spread out.
+ */
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Config.hpp"
+
+/**
+ * @brief Files entity ids by bounding box. Ids are small non-negative integers, e.g. IMG_FILES.
+ */
+class SpatialHash {
+public:
+
+    /**
+     * Constructor
+     * @param cellSize Width and height of a grid cell in pixels, about the size of a typical entity.
+     */
+    SpatialHash(int cellSize = SPATIAL_CELL_SIZE);
+
+    /**
+     * Destructor
+     */
+    ~SpatialHash();
+
+    /**
+     * Add an entity, or move it and change its layers if it is already filed.
+     * @param id The entity.
+     * @param bounds Its bounding box in level pixels.
+     * @param layers Bit mask of the layers the entity belongs to, see SPRITE_LAYER.
+     */
+    void Insert(int id, const SDL_Rect &bounds, Uint32 layers = 1);
+
+    /**
+     * Give a filed entity a new bounding box. Only the cells it enters or
+     * leaves are updated, so small moves inside a cell are nearly free.
+     * Unknown ids are ignored.
+     */
+    void Move(int id, const SDL_Rect &bounds);
+
+    /**
+     * Remove an entity. Unknown ids are ignored.
+     */
+    void Remove(int id);
+
+    /// Whether the entity is filed.
+    bool Contains(int id) const;
+
+    /**
+     * Find every entity whose bounding box overlaps an area.
+     * @param area The area in level pixels.
+     * @param out Cleared, then receives each overlapping id once.
+     */
+    void Query(const SDL_Rect &area, std::vector<int> &out) const;
+
+    /**
+     * Find every pair of entities whose bounding boxes overlap, where one is
+     * on a layer of layersA and the other on a layer of layersB.
+     * @param layersA Layers of the first entity of each pair, e.g. LAYER_PLAYER.
+     * @param layersB Layers of the second entity of each pair, e.g. LAYER_ENEMY.
+     * @param out Cleared, then receives each pair once, sorted. When both
+     *        entities could go first the smaller id does.
+     */
+    void QueryPairs(Uint32 layersA, Uint32 layersB, std::vector<std::pair<int, int>> &out) const;
+
+    /**
+     * Remove every entity.
+     */
+    void Clear();
+
+private:
+    /// An inclusive rectangle of grid cells.
+    struct CellSpan {
+        int firstX;
+        int firstY;
+        int lastX;
+        int lastY;
+
+        bool Contains(int cellX, int cellY) const {
+            return cellX >= firstX && cellX <= lastX && cellY >= firstY && cellY <= lastY;
+        }
+    };
+
+    /// What the grid knows about one id.
+    struct Entry {
+        SDL_Rect bounds;
+        /// The cells the entity is filed under.
+        CellSpan cells;
+        Uint32 layers;
+        bool present;
+        /// The last query that reported this entity, so it is reported once per query.
+        unsigned int queryStamp;
+    };
+
+    /// Hash map key of a grid cell.
+    static Uint64 CellKey(int cellX, int cellY) {
+        return ((Uint64)(Uint32)cellX << 32) | (Uint32)cellY;
+    }
+
+    /// The cells a box overlaps. Zero sized boxes still occupy the cell they sit in.
+    CellSpan SpanOf(const SDL_Rect &bounds) const;
+
+    /// Add an id to every cell of a span that is not also in skip.
+    void AddTo(int id, const CellSpan &span, const CellSpan *skip);
+
+    /// Remove an id from every cell of a span that is not also in skip.
+    void RemoveFrom(int id, const CellSpan &span, const CellSpan *skip);
+
+    /// Width and height of a grid cell in pixels.
+    int cellSize;
+    /// Ids filed under each non-empty cell.
+    std::unordered_map<Uint64, std::vector<int>> cells;
+    /// Indexed by id.
+    mutable std::vector<Entry> entries;
+    /// Counter that tells queries apart.
+    mutable unsigned int queryStamp;
+};
+
+#endif
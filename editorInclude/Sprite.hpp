@@ -11,6 +11,8 @@
 #include <string>
 #include <iostream>
 #include "Config.hpp"
+#include "Camera.hpp"
+#include "RenderStats.hpp"
 
 /**
  * @brief Sprite supports detecting the current orientation and set moving direction functions for characters.
@@ -47,6 +49,18 @@ public:
      */
     void Render(SDL_Renderer *ren);
 
+    /**
+     * @brief Render the sprite where the camera shows it, skipping it when it is off screen.
+     * @param ren Reference to SDL renderer.
+     * @param camera The camera the level is viewed through.
+     */
+    void Render(SDL_Renderer *ren, const Camera &camera);
+
+    /**
+     * @return The area the sprite covers in the level, in pixels.
+     */
+    SDL_Rect GetBounds() const;
+
     /**
      * Set the frame this sprite's animation to 0;
      */
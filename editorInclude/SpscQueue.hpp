@@ -0,0 +1,67 @@
+/**
+ * @file SpscQueue.hpp
+ * @brief This file contains a wait-free queue between exactly one producer and one consumer thread.
+ *
+ * The queue is a ring of fixed capacity indexed by two counters that only
+ * ever grow. The producer alone writes the tail and the consumer alone
+ * writes the head, so neither side ever waits for the other: a push into a
+ * full queue and a pop from an empty one simply fail. Both counters sit on
+ * their own cache line so the two threads do not slow each other down by
+ * writing next to each other.
+ */
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/// Size of a cache line on the CPUs the editor runs on.
+const size_t CACHE_LINE_SIZE {64};
+
+/**
+ * @brief Passes items from one producer thread to one consumer thread without locks.
+ * @tparam T The item type, copied in and out.
+ * @tparam Capacity Maximum number of queued items, a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+
+    /**
+     * Queue an item. Producer thread only.
+     * @return false, without waiting, if the queue is full.
+     */
+    bool TryPush(const T &item) {
+        size_t tailIndex = tail.load(std::memory_order_relaxed);
+        if (tailIndex - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[tailIndex & (Capacity - 1)] = item;
+        // the item must be written before the consumer can see the new tail
+        tail.store(tailIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Take the oldest item. Consumer thread only.
+     * @return false, without waiting, if the queue is empty.
+     */
+    bool TryPop(T &item) {
+        size_t headIndex = head.load(std::memory_order_relaxed);
+        if (headIndex == tail.load(std::memory_order_acquire)) return false;
+        item = items[headIndex & (Capacity - 1)];
+        // the item must be read before the producer can reuse its slot
+        head.store(headIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    /// Number of items taken so far, written by the consumer.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head {0};
+    /// Number of items queued so far, written by the producer.
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail {0};
+    /// The ring, item n is at n % Capacity.
+    alignas(CACHE_LINE_SIZE) T items[Capacity];
+};
+
+#endif
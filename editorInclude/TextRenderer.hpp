@@ -0,0 +1,149 @@
+/**
+ * @file TextRenderer.hpp
+ * @brief This file contains the renderer that draws text from a glyph atlas.
+ *
+ * Every printable ASCII glyph of a font is rasterized with SDL_ttf once, at
+ * Init(), into a single atlas texture. Drawing a string then never touches
+ * the font: the string is laid out into one quad per glyph, all cut from
+ * the same atlas, and the quads are submitted together. Layouts of strings
+ * that do not change, such as menus, are cached by their text, so a static
+ * string costs no layout work after it was first drawn.
+ */
+#ifndef TEXT_RENDERER_HPP
+#define TEXT_RENDERER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SDL_ttf.h>
+#include "Config.hpp"
+#include "RenderStats.hpp"
+
+/// First character rasterized into the atlas.
+const char TEXT_FIRST_GLYPH {' '};
+/// Last character rasterized into the atlas.
+const char TEXT_LAST_GLYPH {'~'};
+
+/**
+ * @brief A string laid out into quads of the glyph atlas.
+ */
+struct TextLayout {
+    /// Part of the atlas every quad shows.
+    std::vector<SDL_Rect> src;
+    /// Where every quad goes, relative to the top left corner of the text.
+    std::vector<SDL_Rect> dst;
+    /// Size of the laid out text in pixels.
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * @brief Draws strings from a glyph atlas with one batch per string.
+ */
+class TextRenderer {
+public:
+
+    /**
+     * Constructor
+     */
+    TextRenderer();
+
+    /**
+     * Destructor
+     */
+    ~TextRenderer();
+
+    /**
+     * Rasterize the glyphs of a font into the atlas.
+     * @param ren Reference to SDL renderer.
+     * @param fontPath The file name of a TrueType font.
+     * @param pointSize Size of the font in points.
+     * @return Whether the atlas was created.
+     */
+    bool Init(SDL_Renderer *ren, const char *const fontPath, int pointSize);
+
+    /**
+     * Lay out a string. Characters without a glyph in the atlas are drawn as
+     * '?' and '\n' starts a new line.
+     * @param text The string to lay out, null terminated.
+     * @param layout Receives the quads of the string.
+     */
+    void Layout(const char *text, TextLayout &layout) const;
+
+    /**
+     * The cached layout of a string that does not change, laid out on first use.
+     * @param text The string.
+     * @return The layout, valid until ClearCache() or Destroy(). Once the cache
+     *         is full, strings that are not in it get a layout that is only
+     *         valid until the next such call.
+     */
+    const TextLayout &GetLayout(const std::string &text);
+
+    /**
+     * Draw laid out text.
+     * @param ren Reference to SDL renderer.
+     * @param layout The text, laid out by this renderer.
+     * @param x Left edge of the text on screen.
+     * @param y Top edge of the text on screen.
+     * @param color Color of the text.
+     */
+    void Draw(SDL_Renderer *ren, const TextLayout &layout, int x, int y, SDL_Color color);
+
+    /**
+     * Draw a string that does not change, through its cached layout.
+     */
+    void DrawText(SDL_Renderer *ren, const std::string &text, int x, int y, SDL_Color color);
+
+    /**
+     * Draw a string that changes from frame to frame, without caching its layout.
+     * Once the reused layout has grown to the longest string this allocates nothing.
+     */
+    void DrawDynamicText(SDL_Renderer *ren, const char *text, int x, int y, SDL_Color color);
+
+    /// Distance between the tops of two lines of text.
+    int GetLineHeight() const { return lineHeight; }
+
+    /**
+     * Forget every cached layout.
+     */
+    void ClearCache();
+
+    /**
+     * Free the atlas and every cached layout.
+     */
+    void Destroy();
+
+private:
+    /// Where a glyph is in the atlas and how far it moves the pen.
+    struct Glyph {
+        SDL_Rect src;
+        int advance;
+    };
+
+    /// The glyph drawn for a character.
+    const Glyph &GetGlyph(char c) const;
+
+    /// Every glyph of the font, from TEXT_FIRST_GLYPH to TEXT_LAST_GLYPH.
+    std::vector<Glyph> glyphs;
+    /// The texture all glyphs are cut from.
+    SDL_Texture *atlas;
+    /// Size of the atlas in pixels.
+    int atlasWidth;
+    int atlasHeight;
+    /// Distance between the tops of two lines of text.
+    int lineHeight;
+
+    /// Layouts of static strings by their text.
+    std::unordered_map<std::string, TextLayout> cache;
+    /// Layout of the last dynamic string, reused to keep its memory.
+    TextLayout scratchLayout;
+    /// Layout of the last string GetLayout() could not cache.
+    TextLayout uncachedLayout;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    /// Vertices and indices of the quads being drawn, reused between draws.
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+#endif
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @file TileFill.hpp
+ * @brief This file contains the fill tools of the level editor.
+ *
+ * The tools never write a tile at a time. A flood fill scans whole runs of
+ * matching tiles in row buffers that only cover the chunks it reached, and
+ * writes every touched row back with a single row span, and rectangle and
+ * stamp fills build each row once and copy it in. Each tool returns one
+ * TileChangeSet describing everything it changed.
+ */
+#ifndef TILE_FILL_HPP
+#define TILE_FILL_HPP
+
+#include "Config.hpp"
+#include "TileMap.hpp"
+
+/**
+ * Replace the 4-connected region of identical tiles around a cell. The
+ * region ends at absent chunks, see TileMap::SetChunkAbsent().
+ * @param map The map to fill.
+ * @param x Tile column of the seed cell.
+ * @param y Tile row of the seed cell.
+ * @param id The tile id the region becomes.
+ * @return The tiles that changed.
+ */
+TileChangeSet FloodFill(TileMap &map, int x, int y, TileID id);
+
+/**
+ * Set every tile of a rectangle to one id.
+ * @param map The map to fill.
+ * @param area Tile columns and rows, clipped to the map.
+ * @param id The tile id the rectangle becomes.
+ * @return The tiles that were written.
+ */
+TileChangeSet FillRect(TileMap &map, const SDL_Rect &area, TileID id);
+
+/**
+ * Cover a rectangle with copies of a stamp, repeated from its top left corner.
+ * @param map The map to fill.
+ * @param area Tile columns and rows, clipped to the map.
+ * @param stamp stampWidth * stampHeight tile ids row by row.
+ * @param stampWidth Number of columns of the stamp.
+ * @param stampHeight Number of rows of the stamp.
+ * @return The tiles that were written.
+ */
+TileChangeSet StampRect(TileMap &map, const SDL_Rect &area, const TileID *stamp,
+                        int stampWidth, int stampHeight);
+
+#endif
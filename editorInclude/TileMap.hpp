@@ -0,0 +1,391 @@
+/**
+ * @file TileMap.hpp
+ * @brief This file contains the grid of tile ids that makes up a level.
+ *
+ * The grid is split into square chunks of TILE_CHUNK_SIZE tiles. Every
+ * edit bumps the version of the chunk it lands in, so caches built from
+ * the map only need to rebuild the chunks whose version has changed.
+ *
+ * Chunks without any tile are not stored at all. In sparse storage the
+ * remaining chunks are kept run length encoded, row by row, and only
+ * expanded while they are being edited, so memory scales with the content
+ * of the level rather than with its area.
+ *
+ * Edits made through SetTile() and SetRowSpan() are noted in an attached
+ * EditJournal for undo. Tiles read from files or streams are written with
+ * LoadRowSpan() and are not.
+ *
+ * A chunk can be marked absent while its tiles live only in a level file,
+ * e.g. while it is streamed out. Absent chunks read as empty and edits skip
+ * them, so an edit never lands in a chunk that loading would overwrite.
+ */
+#ifndef TILEMAP_HPP
+#define TILEMAP_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include "Config.hpp"
+
+/// Tile ids index the tile sheet from left to right, top to bottom.
+typedef Sint16 TileID;
+/// Id used by the level files for a cell without a tile.
+const TileID EMPTY_TILE {-1};
+
+class EditJournal;
+
+static_assert(TILE_CHUNK_SIZE <= 255, "run starts and lengths inside a chunk row are stored in one byte");
+
+/// How the chunks of a TileMap are kept in memory.
+enum TILE_STORAGE {
+    /// Every stored chunk is a plain array, for maps that are edited a lot.
+    STORAGE_DENSE = 0,
+    /// Chunks are run length encoded and expanded only while edited.
+    STORAGE_SPARSE
+};
+
+/// A run of identical, non-empty tiles inside one row of an encoded chunk.
+struct TileRun {
+    TileID id;
+    /// Column of the first tile, relative to the chunk.
+    Uint8 start;
+    Uint8 length;
+};
+
+/// The stored tiles of one chunk. Either tiles or runs is in use.
+struct TileChunk {
+    /// TILE_CHUNK_SIZE * TILE_CHUNK_SIZE ids row by row, empty while the chunk is encoded.
+    std::vector<TileID> tiles;
+    /// The runs of every row, row by row. Gaps between runs are empty tiles.
+    std::vector<TileRun> runs;
+    /// Index of the first run of each row in runs, followed by runs.size().
+    Uint16 rowStart[TILE_CHUNK_SIZE + 1];
+    /// Whether the chunk was expanded for editing since the last TileMap::Compact().
+    bool written;
+
+    /// Whether the tiles are stored as a plain array.
+    bool IsDense() const { return !tiles.empty(); }
+};
+
+/**
+ * @brief The tiles one operation changed, so caches built from the map can
+ * catch up once per operation instead of once per tile.
+ */
+struct TileChangeSet {
+    /// Bounding box of the changed tiles, in tile columns and rows. Empty when w is 0.
+    SDL_Rect area;
+    /// Indices of the changed chunks, row by row, sorted and unique after Finish().
+    std::vector<int> chunks;
+    /// Number of tiles written.
+    size_t tileCount;
+
+    TileChangeSet():area{0, 0, 0, 0},tileCount(0) {}
+
+    /// Whether nothing changed.
+    bool IsEmpty() const { return tileCount == 0; }
+
+    /**
+     * Note a span of tiles written in one row.
+     * @param chunkCols Number of chunk columns of the map.
+     */
+    void AddSpan(int chunkCols, int x, int y, int count);
+
+    /// Sort and deduplicate chunks once the operation is done.
+    void Finish();
+};
+
+/**
+ * @brief A rectangular grid of tile ids with per-chunk change tracking.
+ */
+class TileMap {
+public:
+
+    /**
+     * Constructor
+     */
+    TileMap();
+
+    /**
+     * Constructor
+     * @param width Number of tile columns.
+     * @param height Number of tile rows.
+     */
+    TileMap(int width, int height);
+
+    /**
+     * Destructor
+     */
+    ~TileMap();
+
+    /**
+     * Replace the map with an empty grid of the given size. Clears the attached journal.
+     * @param width Number of tile columns.
+     * @param height Number of tile rows.
+     */
+    void Resize(int width, int height);
+
+    /**
+     * Replace the map with a grid of tiles built elsewhere.
+     * @param width Number of tile columns.
+     * @param height Number of tile rows.
+     * @param newTiles width * height tile ids row by row, released before Assign() returns.
+     */
+    void Assign(int width, int height, std::vector<TileID> &&newTiles);
+
+    /**
+     * Load a level stored as whitespace separated tile ids, one row per line,
+     * or a binary level (see LevelFile.hpp). Malformed rows are logged with their line number.
+     * @param filePath The file name of the level file.
+     * @return Whether the level was loaded.
+     */
+    bool LoadFromFile(const std::string &filePath);
+
+    /**
+     * Write the level in the same text format LoadFromFile() reads.
+     * @param filePath The file name of the level file.
+     * @return Whether the level was written.
+     */
+    bool SaveToFile(const std::string &filePath) const;
+
+    /**
+     * Switch between dense and sparse storage. Switching to sparse compacts every chunk.
+     * @param mode One of TILE_STORAGE.
+     */
+    void SetStorage(TILE_STORAGE mode);
+
+    /// The current storage mode.
+    TILE_STORAGE GetStorage() const { return storage; }
+
+    /**
+     * In sparse storage, encode the chunks that were expanded by edits since the
+     * last call and drop the ones that became empty. Cheap when nothing was edited.
+     */
+    void Compact();
+
+    /**
+     * @return Bytes held by the tile storage, chunk table included.
+     */
+    size_t GetMemoryUsage() const;
+
+    /// Number of tile columns.
+    int GetWidth() const { return width; }
+    /// Number of tile rows.
+    int GetHeight() const { return height; }
+
+    /**
+     * @param x Tile column.
+     * @param y Tile row.
+     * @return The tile id, or EMPTY_TILE outside of the map.
+     */
+    TileID GetTile(int x, int y) const;
+
+    /**
+     * Change one tile and mark its chunk as changed. Writes outside of the map
+     * or into an absent chunk are ignored.
+     * @param x Tile column.
+     * @param y Tile row.
+     * @param id The new tile id.
+     */
+    void SetTile(int x, int y, TileID id);
+
+    /**
+     * Copy a run of tiles into one row, marking every chunk it touches as changed once.
+     * The run is clipped to the map, and its tiles in absent chunks are skipped.
+     * @param x Tile column of the first tile.
+     * @param y Tile row.
+     * @param ids The new tile ids.
+     * @param count Number of tiles in ids.
+     */
+    void SetRowSpan(int x, int y, const TileID *ids, int count);
+
+    /**
+     * Same as SetRowSpan() for tiles that come from a level file or a stream
+     * rather than from an edit, so they are never journaled. Writes into
+     * absent chunks too.
+     */
+    void LoadRowSpan(int x, int y, const TileID *ids, int count);
+
+    /**
+     * Note every edit in a journal while it has a transaction open.
+     * @param journal The journal, or nullptr to stop noting edits.
+     */
+    void SetJournal(EditJournal *journal) { this->journal = journal; }
+
+    /**
+     * Drop every tile of a chunk, e.g. when it is paged out, and mark it as changed.
+     * @param chunkX Chunk column.
+     * @param chunkY Chunk row.
+     */
+    void ClearChunk(int chunkX, int chunkY);
+
+    /**
+     * Copy a run of tiles out of one row. Tiles outside of the map read as EMPTY_TILE.
+     * @param x Tile column of the first tile.
+     * @param y Tile row.
+     * @param out Receives count tile ids.
+     * @param count Number of tiles to copy.
+     */
+    void CopyRowSpan(int x, int y, TileID *out, int count) const;
+
+    /**
+     * Visit the non-empty tiles of a run of one row, grouped into runs of the same id.
+     * Chunks without tiles are skipped without being looked at.
+     * @param x Tile column of the first tile.
+     * @param y Tile row.
+     * @param count Number of tiles to visit.
+     * @param visit Called as visit(int firstX, int length, TileID id) from left to right.
+     */
+    template<typename Visitor>
+    void ForEachTileRun(int x, int y, int count, Visitor visit) const;
+
+    /// Whether the tile position lies inside the map.
+    bool InBounds(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+
+    /// Whether the tile position lies inside the map and edits to it are kept, i.e. its chunk is not absent.
+    bool IsEditable(int x, int y) const;
+
+    /**
+     * Mark a chunk whose tiles are held by a level file rather than by the map,
+     * or clear the mark once they were loaded. Resize() clears every mark.
+     * @param chunkX Chunk column.
+     * @param chunkY Chunk row.
+     * @param absent Whether the chunk is absent.
+     */
+    void SetChunkAbsent(int chunkX, int chunkY, bool absent);
+
+    /// Whether a chunk is marked absent, see SetChunkAbsent().
+    bool IsChunkAbsent(int chunkX, int chunkY) const;
+
+    /// Number of chunk columns.
+    int GetChunkCols() const { return chunkCols; }
+    /// Number of chunk rows.
+    int GetChunkRows() const { return chunkRows; }
+
+    /**
+     * @param chunkX Chunk column.
+     * @param chunkY Chunk row.
+     * @return A counter that changes every time a tile of the chunk changes.
+     */
+    unsigned int GetChunkVersion(int chunkX, int chunkY) const;
+
+    /**
+     * Like GetChunkVersion(), but only edits made through SetTile() and
+     * SetRowSpan() change it, not loading, streaming or ClearChunk().
+     * @param chunkX Chunk column.
+     * @param chunkY Chunk row.
+     * @return A counter of the edits to the chunk, 0 for a chunk never edited.
+     */
+    unsigned int GetChunkEditVersion(int chunkX, int chunkY) const;
+
+    /**
+     * Hand over the chunks whose version changed, or that became absent or
+     * present, since the last call, each once, so per-chunk state can follow
+     * the map without looking at every chunk. A new grid or fresh versions
+     * report every chunk. There is one taker, the collision map.
+     * @param out Receives the chunk indices, chunkY * GetChunkCols() + chunkX.
+     */
+    void TakeChangedChunks(std::vector<int> &out);
+
+private:
+    /// Expand a chunk into a plain array for editing, creating it if it is not stored.
+    TileChunk &EditChunk(int chunkIndex);
+
+    /// Encode an expanded chunk, or drop it when it has no tile left.
+    void CompactChunk(int chunkIndex);
+
+    /// Bump the version of the chunk that contains the tile.
+    void MarkChanged(int x, int y);
+
+    /// Move every chunk to a version newer than any it had before.
+    void ResetChunkVersions();
+
+    /// Bump the version of every chunk that a run of tiles in one row touches.
+    void MarkSpanChanged(int x, int y, int count);
+
+    /// Queue a chunk for TakeChangedChunks() unless it is queued already.
+    void NoteChanged(int chunkIndex);
+
+    /// Number of tile columns.
+    int width;
+    /// Number of tile rows.
+    int height;
+    /// Number of chunk columns.
+    int chunkCols;
+    /// Number of chunk rows.
+    int chunkRows;
+
+    /// The current storage mode.
+    TILE_STORAGE storage;
+
+    /// Where edits are noted, may be nullptr.
+    EditJournal *journal;
+
+    /// Old ids of a span being journaled.
+    std::vector<TileID> journalIds;
+
+    /// The stored chunks row by row, nullptr for chunks without any tile.
+    std::vector<std::unique_ptr<TileChunk>> chunks;
+
+    /// Chunks expanded by edits since the last Compact(), sparse storage only.
+    std::vector<int> writtenChunks;
+
+    /// One change counter per chunk, stored row by row.
+    std::vector<unsigned int> chunkVersions;
+
+    /// One edit counter per chunk, stored row by row.
+    std::vector<unsigned int> editVersions;
+
+    /// Whether each chunk is absent, stored row by row.
+    std::vector<Uint8> absentChunks;
+
+    /// Chunks changed since the last TakeChangedChunks(), and a flag per chunk that it is among them.
+    std::vector<int> changedChunks;
+    std::vector<Uint8> changedFlags;
+};
+
+template<typename Visitor>
+void TileMap::ForEachTileRun(int x, int y, int count, Visitor visit) const {
+    if (y < 0 || y >= height) return;
+    int end = std::min(x + count, width);
+    x = std::max(x, 0);
+    int row = y % TILE_CHUNK_SIZE;
+    const std::unique_ptr<TileChunk> *chunkRow = &chunks[(y / TILE_CHUNK_SIZE) * chunkCols];
+    // a run is only reported once it cannot grow any more, so runs continue across chunks
+    int runStart = 0, runLength = 0;
+    TileID runId = EMPTY_TILE;
+    auto extend = [&](int tileX, int length, TileID id) {
+        if (runLength > 0 && runId == id && runStart + runLength == tileX) {
+            runLength += length;
+            return;
+        }
+        if (runLength > 0) visit(runStart, runLength, runId);
+        runStart = tileX;
+        runLength = length;
+        runId = id;
+    };
+    while (x < end) {
+        int chunkX = x / TILE_CHUNK_SIZE;
+        int chunkLeft = chunkX * TILE_CHUNK_SIZE;
+        int segmentEnd = std::min(end, chunkLeft + TILE_CHUNK_SIZE);
+        const TileChunk *chunk = chunkRow[chunkX].get();
+        if (chunk != nullptr && chunk->IsDense()) {
+            const TileID *tiles = chunk->tiles.data() + row * TILE_CHUNK_SIZE;
+            for (int tileX = x; tileX < segmentEnd; tileX++) {
+                TileID id = tiles[tileX - chunkLeft];
+                if (id != EMPTY_TILE) extend(tileX, 1, id);
+            }
+        } else if (chunk != nullptr) {
+            for (int i = chunk->rowStart[row]; i < chunk->rowStart[row + 1]; i++) {
+                const TileRun &run = chunk->runs[i];
+                int first = std::max(x, chunkLeft + run.start);
+                int last = std::min(segmentEnd, chunkLeft + run.start + run.length);
+                if (first < last) extend(first, last - first, run.id);
+            }
+        }
+        x = segmentEnd;
+    }
+    if (runLength > 0) visit(runStart, runLength, runId);
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file TileMapRenderer.hpp
+ * @brief This file contains the renderer that draws a TileMap through baked chunk textures.
+ *
+ * Every chunk of the map is drawn tile by tile into its own render target
+ * texture once. A frame then only copies the chunk textures that overlap
+ * the view, and a chunk is baked again only when its version in the map
+ * has changed.
+ */
+#ifndef TILEMAP_RENDERER_HPP
+#define TILEMAP_RENDERER_HPP
+
+#include <vector>
+#include "Config.hpp"
+#include "TileMap.hpp"
+#include "Camera.hpp"
+#include "RenderStats.hpp"
+
+/**
+ * @brief Draws a TileMap with one SDL_RenderCopy per visible chunk.
+ */
+class TileMapRenderer {
+public:
+
+    /**
+     * Constructor
+     */
+    TileMapRenderer();
+
+    /**
+     * Destructor
+     */
+    ~TileMapRenderer();
+
+    /**
+     * Load the tile sheet.
+     * @param ren Reference to SDL renderer. It must support render targets.
+     * @param tileSheetPath The file name of the tile sheet image.
+     * @return Whether the tile sheet was loaded.
+     */
+    bool Init(SDL_Renderer *ren, const char *const tileSheetPath);
+
+    /**
+     * Attach the map to draw. All chunk textures are rebuilt on the next Render().
+     * @param map The map to draw, it must outlive this renderer or be replaced.
+     */
+    void SetTileMap(const TileMap *map);
+
+    /**
+     * Drop every baked chunk, e.g. after SDL reports that render targets were reset.
+     */
+    void InvalidateAll();
+
+    /**
+     * Bake the chunks that changed and copy the ones the camera can see. Chunks
+     * outside of the view are neither baked nor looked at.
+     * @param ren Reference to SDL renderer.
+     * @param camera The camera the level is viewed through.
+     */
+    void Render(SDL_Renderer *ren, const Camera &camera);
+
+    /**
+     * Free the tile sheet and all chunk textures.
+     */
+    void Destroy();
+
+private:
+    /// Redraw one chunk into its texture, creating the texture if needed.
+    void BakeChunk(SDL_Renderer *ren, int chunkX, int chunkY);
+
+    /// Free all chunk textures.
+    void ClearChunks();
+
+    /// The map being drawn.
+    const TileMap *tileMap;
+
+    /// The tile sheet every tile is copied from.
+    SDL_Texture *tileSheet;
+
+    /// Number of tile columns on the tile sheet.
+    int sheetCols;
+
+    /// Baked chunk textures, row by row. Chunks without any tile have no texture.
+    std::vector<SDL_Texture*> chunkTextures;
+
+    /// The map's chunk version each texture was baked from, 0 if never baked.
+    std::vector<unsigned int> bakedVersions;
+};
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file VoiceManager.hpp
+ * @brief This file contains the budget that decides which sound effects get a voice.
+ *
+ * Gameplay code triggers sounds freely, e.g. one footstep per enemy, and
+ * the voice manager turns that into a bounded number of voices. Triggers
+ * of the same sound within one update are coalesced into a single voice
+ * at the loudest of their volumes. Each sound may only play a limited
+ * number of times at once, and all sounds share a hard budget of
+ * VOICE_BUDGET voices. When either limit is reached the least important
+ * voice, by priority and then by volume after distance attenuation, is
+ * stolen for the new sound, or the new sound is culled if it matters less
+ * than everything playing. The mixing cost therefore stays bounded however
+ * many entities make noise.
+ *
+ * The manager runs on the game thread. Once per update it retires the
+ * voices the mixer reports as over, from the handles the audio thread
+ * publishes after every callback, so it never waits on the audio thread.
+ */
+#ifndef VOICE_MANAGER_HPP
+#define VOICE_MANAGER_HPP
+
+#include <chrono>
+#include <vector>
+#include "Config.hpp"
+#include "AudioMixer.hpp"
+
+/**
+ * @brief Starts sound effects on an AudioMixer within a voice budget.
+ */
+class VoiceManager {
+public:
+
+    /**
+     * Constructor
+     */
+    VoiceManager();
+
+    /**
+     * Destructor
+     */
+    ~VoiceManager();
+
+    /**
+     * Set the mixer the voices are played on.
+     * @param mixer The mixer, it must outlive this manager or be replaced.
+     */
+    void SetMixer(AudioMixer *mixer);
+
+    /**
+     * Set how a sound competes for voices.
+     * @param sound The sound.
+     * @param priority Voices of higher priority are never stolen for lower ones.
+     * @param maxInstances Number of voices the sound may play on at once.
+     */
+    void SetSoundRules(SoundID sound, int priority, int maxInstances);
+
+    /**
+     * Move the listener, e.g. to the center of the camera view.
+     * @param x Level x coordinate in pixels.
+     * @param y Level y coordinate in pixels.
+     */
+    void SetListener(int x, int y);
+
+    /**
+     * Ask for a sound at a point of the level. It is quieter the further it
+     * is from the listener and panned to its side. Sounds only start at
+     * the next Update().
+     * @param sound The sound.
+     * @param x Level x coordinate in pixels.
+     * @param y Level y coordinate in pixels.
+     * @param volume From 0 to 1, before attenuation.
+     */
+    void Trigger(SoundID sound, int x, int y, float volume = 1);
+
+    /**
+     * Ask for a sound that has no place in the level, e.g. for the editor UI.
+     */
+    void Trigger(SoundID sound, float volume = 1);
+
+    /**
+     * Start the sounds triggered since the last update that fit into the
+     * budget. Call once per update.
+     */
+    void Update();
+
+    /**
+     * Stop every voice started by this manager and forget pending triggers.
+     */
+    void StopAll();
+
+    /// Number of voices playing, as of the last update.
+    int GetActiveVoices() const { return (int)voices.size(); }
+
+    /// Number of triggers merged into another trigger of the same update so far.
+    int GetCoalescedTriggers() const { return coalesced; }
+
+    /// Number of triggers that got no voice or lost theirs to a more important sound so far.
+    int GetCulledVoices() const { return culled; }
+
+private:
+    /// How a sound competes for voices and what was triggered for it.
+    struct SoundState {
+        int priority;
+        int maxInstances;
+        /// Voices the sound plays on.
+        int playing;
+        /// Whether the sound was triggered since the last update, and at which volume and pan.
+        bool triggered;
+        float volume;
+        float pan;
+    };
+
+    /// A voice started by the manager.
+    struct ActiveVoice {
+        VoiceHandle handle;
+        SoundID sound;
+        int priority;
+        float volume;
+        /// When the sound should be over, to steal the voice closest to its end first.
+        std::chrono::steady_clock::time_point end;
+    };
+
+    /// The state of a sound, added with default rules when first seen.
+    SoundState &GetState(SoundID sound);
+
+    /// Record a trigger, merging it with an earlier one of the same update.
+    void AddTrigger(SoundID sound, float volume, float pan);
+
+    /// Forget the voices the mixer no longer plays.
+    void RetireFinished();
+
+    /**
+     * The least important voice a new voice could take, or -1 if every
+     * candidate matters at least as much as the new one.
+     * @param sound Only voices of this sound are candidates, -1 for all voices.
+     */
+    int FindVictim(SoundID sound, int priority, float volume) const;
+
+    /// Stop a voice and forget it.
+    void StealVoice(int index);
+
+    /// The mixer the voices play on.
+    AudioMixer *mixer;
+    /// Rules and triggers by sound id.
+    std::vector<SoundState> sounds;
+    /// The sounds triggered since the last update, reused between updates.
+    std::vector<SoundID> triggered;
+    /// The voices started and not yet over, at most VOICE_BUDGET.
+    std::vector<ActiveVoice> voices;
+    /// Where the listener is in the level.
+    int listenerX;
+    int listenerY;
+    /// Counters of merged and culled triggers.
+    int coalesced;
+    int culled;
+};
+
+#endif
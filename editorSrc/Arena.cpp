@@ -0,0 +1,87 @@
+/**
+ * @file Arena.cpp
+ * @brief This file contains the linear allocators for data that lives for one frame or one level.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "Arena.hpp"
+
+namespace {
+
+// block data starts this far after the block header, so it is aligned like malloc's memory
+const size_t BLOCK_HEADER_BYTES {(sizeof(void*) + sizeof(size_t) + alignof(std::max_align_t) - 1)
+                                 / alignof(std::max_align_t) * alignof(std::max_align_t)};
+
+}
+
+Arena::Arena(size_t blockBytes):blockBytes(blockBytes),blocks(nullptr),cursor(nullptr),end(nullptr),
+                                usedBytes(0),peakBytes(0),capacityBytes(0) {
+}
+
+Arena::~Arena() {
+    FreeBlocks();
+}
+
+void *Arena::Allocate(size_t bytes, size_t alignment) {
+    uintptr_t address = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (cursor == nullptr || address + bytes > (uintptr_t)end) {
+        // the rest of the current block is left unused
+        AddBlock(std::max(blockBytes, bytes + alignment));
+        address = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    usedBytes += address + bytes - (uintptr_t)cursor;
+    peakBytes = std::max(peakBytes, usedBytes);
+    cursor = reinterpret_cast<Uint8*>(address + bytes);
+    return reinterpret_cast<void*>(address);
+}
+
+void Arena::Reset() {
+    usedBytes = 0;
+    if (blocks == nullptr) return;
+    if (blocks->next != nullptr) {
+        // the frame did not fit one block, from now on one block holds all of it
+        size_t total = capacityBytes;
+        FreeBlocks();
+        AddBlock(total);
+        return;
+    }
+    cursor = reinterpret_cast<Uint8*>(blocks) + BLOCK_HEADER_BYTES;
+}
+
+void Arena::Release() {
+    FreeBlocks();
+    usedBytes = 0;
+}
+
+void Arena::AddBlock(size_t bytes) {
+    Block *block = static_cast<Block*>(malloc(BLOCK_HEADER_BYTES + bytes));
+    if (block == nullptr) throw std::bad_alloc();
+    block->next = blocks;
+    block->size = bytes;
+    blocks = block;
+    cursor = reinterpret_cast<Uint8*>(block) + BLOCK_HEADER_BYTES;
+    end = cursor + bytes;
+    capacityBytes += bytes;
+}
+
+void Arena::FreeBlocks() {
+    while (blocks != nullptr) {
+        Block *next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+    cursor = end = nullptr;
+    capacityBytes = 0;
+}
+
+Arena &GetFrameArena() {
+    static Arena arena(FRAME_ARENA_BYTES);
+    return arena;
+}
+
+Arena &GetLevelArena() {
+    static Arena arena(LEVEL_ARENA_BYTES);
+    return arena;
+}
@@ -0,0 +1,280 @@
+/**
+ * @file AudioMixer.cpp
+ * @brief This file contains the software mixer that plays sound effects on the audio thread.
+ */
+#include <algorithm>
+#include <cmath>
+#include "AudioMixer.hpp"
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define MIXER_SSE2
+#endif
+
+namespace {
+
+// out += in * gain for interleaved stereo, samples is even and both start on a left sample
+void AddScaledStereo(float *out, const float *in, int samples, float gainLeft, float gainRight) {
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 gains8 = _mm256_setr_ps(gainLeft, gainRight, gainLeft, gainRight,
+                                         gainLeft, gainRight, gainLeft, gainRight);
+    for (; i + 8 <= samples; i += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), gains8));
+        _mm256_storeu_ps(out + i, sum);
+    }
+#endif
+#if defined(MIXER_SSE2)
+    const __m128 gains4 = _mm_setr_ps(gainLeft, gainRight, gainLeft, gainRight);
+    for (; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), gains4)));
+    }
+#endif
+    for (; i < samples; i += 2) {
+        out[i] += in[i] * gainLeft;
+        out[i + 1] += in[i + 1] * gainRight;
+    }
+}
+
+// stream += mix, with mix scaled from [-1, 1] to 16 bit and the sum clipped to 16 bit
+void AddToStream(Sint16 *stream, const float *mix, int samples) {
+    int i = 0;
+#if defined(MIXER_SSE2)
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 lowest = _mm_set1_ps(-32768.0f), highest = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i pcm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stream + i));
+        // sign extend the eight 16 bit samples to two vectors of 32 bit
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+        __m128 sumLow = _mm_add_ps(_mm_cvtepi32_ps(low), _mm_mul_ps(_mm_loadu_ps(mix + i), scale));
+        __m128 sumHigh = _mm_add_ps(_mm_cvtepi32_ps(high), _mm_mul_ps(_mm_loadu_ps(mix + i + 4), scale));
+        // clip before converting, out of range floats do not convert to anything useful
+        sumLow = _mm_min_ps(_mm_max_ps(sumLow, lowest), highest);
+        sumHigh = _mm_min_ps(_mm_max_ps(sumHigh, lowest), highest);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(sumLow), _mm_cvtps_epi32(sumHigh));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(stream + i), packed);
+    }
+#endif
+    for (; i < samples; i++) {
+        float sum = stream[i] + mix[i] * 32767.0f;
+        sum = std::min(std::max(sum, -32768.0f), 32767.0f);
+        stream[i] = (Sint16)std::lrint(sum);
+    }
+}
+
+}
+
+AudioMixer::AudioMixer():nextHandle(1),droppedCommands(0),frequency(AUDIO_FREQUENCY),running(false),activeVoices(0),
+                        lastPlayCommand(0),appliedHandle(0) {
+    for (Voice &voice : voices) voice = {nullptr, 0, 0, 0, 0, false};
+    for (std::atomic<VoiceHandle> &handle : playingHandles) handle.store(0, std::memory_order_relaxed);
+}
+
+AudioMixer::~AudioMixer() {
+    Stop();
+}
+
+bool AudioMixer::Start() {
+    if (running) return true;
+    int deviceFrequency, channels;
+    Uint16 format;
+    if (Mix_QuerySpec(&deviceFrequency, &format, &channels) == 0) {
+        SDL_Log("The audio device is not open");
+        return false;
+    }
+    if (format != AUDIO_S16SYS || channels != 2) {
+        SDL_Log("The mixer needs 16 bit stereo audio, the device has format %x with %d channels", format, channels);
+        return false;
+    }
+    frequency = deviceFrequency;
+    Mix_SetPostMix(MixCallback, this);
+    running = true;
+    return true;
+}
+
+void AudioMixer::Stop() {
+    if (!running) return;
+    // SDL_mixer swaps the hook while holding the audio lock, so the callback is not running past this
+    Mix_SetPostMix(nullptr, nullptr);
+    running = false;
+    for (Voice &voice : voices) voice.sound = nullptr;
+    activeVoices.store(0, std::memory_order_relaxed);
+    // the voices started so far are over, including those whose commands were never taken
+    for (std::atomic<VoiceHandle> &handle : playingHandles) handle.store(0, std::memory_order_relaxed);
+    lastPlayCommand = nextHandle - 1;
+    appliedHandle.store(lastPlayCommand, std::memory_order_release);
+}
+
+SoundID AudioMixer::LoadSound(const char *const soundPath) {
+    // SDL_mixer decodes the file and converts it to the device format
+    Mix_Chunk *chunk = Mix_LoadWAV(soundPath);
+    if (nullptr == chunk) {
+        SDL_Log("Failed to load sound %s: %s", soundPath, Mix_GetError());
+        return -1;
+    }
+    const Sint16 *pcm = reinterpret_cast<const Sint16*>(chunk->abuf);
+    std::vector<float> samples(chunk->alen / sizeof(Sint16) & ~(size_t)1);
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = pcm[i] / 32768.0f;
+    Mix_FreeChunk(chunk);
+    return AddSound(std::move(samples));
+}
+
+SoundID AudioMixer::AddTone(float toneFrequency, float seconds) {
+    int frames = std::max(1, (int)(seconds * frequency));
+    std::vector<float> samples(frames * 2);
+    const float twoPi = 6.28318530718f;
+    for (int i = 0; i < frames; i++) {
+        // fade out quadratically so the tone ends without a click
+        float fade = 1.0f - (float)i / frames;
+        float sample = 0.5f * fade * fade * std::sin(twoPi * toneFrequency * i / frequency);
+        samples[i * 2] = sample;
+        samples[i * 2 + 1] = sample;
+    }
+    return AddSound(std::move(samples));
+}
+
+SoundID AudioMixer::AddSound(std::vector<float> &&samples) {
+    if (samples.empty()) return -1;
+    std::unique_ptr<SoundBuffer> sound(new SoundBuffer);
+    sound->frames = (int)(samples.size() / 2);
+    sound->samples = std::move(samples);
+    sounds.push_back(std::move(sound));
+    return (SoundID)sounds.size() - 1;
+}
+
+VoiceHandle AudioMixer::Play(SoundID sound, float volume, float pan, bool loop) {
+    if (sound < 0 || sound >= (int)sounds.size()) return 0;
+    VoiceHandle handle = nextHandle++;
+    if (nextHandle == 0) nextHandle = 1;
+    Command command {COMMAND_PLAY, handle, sounds[sound].get(), 0, 0, loop};
+    ToGains(volume, pan, command.gainLeft, command.gainRight);
+    return Send(command) ? handle : 0;
+}
+
+bool AudioMixer::IsVoicePlaying(VoiceHandle voice) const {
+    if (voice == 0) return false;
+    // handles are handed out in order, so every handle after the applied one is still queued
+    if ((Sint32)(voice - appliedHandle.load(std::memory_order_acquire)) > 0) return true;
+    for (const std::atomic<VoiceHandle> &handle : playingHandles) {
+        if (handle.load(std::memory_order_relaxed) == voice) return true;
+    }
+    return false;
+}
+
+double AudioMixer::GetSoundSeconds(SoundID sound) const {
+    if (sound < 0 || sound >= (int)sounds.size()) return 0;
+    return (double)sounds[sound]->frames / frequency;
+}
+
+void AudioMixer::StopVoice(VoiceHandle voice) {
+    if (voice != 0) Send({COMMAND_STOP, voice, nullptr, 0, 0, false});
+}
+
+void AudioMixer::SetVolume(VoiceHandle voice, float volume, float pan) {
+    if (voice == 0) return;
+    Command command {COMMAND_VOLUME, voice, nullptr, 0, 0, false};
+    ToGains(volume, pan, command.gainLeft, command.gainRight);
+    Send(command);
+}
+
+void AudioMixer::StopAll() {
+    Send({COMMAND_STOP_ALL, 0, nullptr, 0, 0, false});
+}
+
+void AudioMixer::Mix(Sint16 *stream, int frames) {
+    ApplyCommands();
+    for (int done = 0; done < frames; ) {
+        int count = std::min(MIXER_BLOCK_FRAMES, frames - done);
+        bool mixed = false;
+        for (Voice &voice : voices) {
+            if (voice.sound == nullptr) continue;
+            // silence is left alone, the block is only cleared once a voice plays
+            if (!mixed) {
+                std::fill(mixBlock, mixBlock + count * 2, 0.0f);
+                mixed = true;
+            }
+            for (int filled = 0; filled < count && voice.sound != nullptr; ) {
+                int length = std::min(count - filled, voice.sound->frames - voice.position);
+                AddScaledStereo(mixBlock + filled * 2, &voice.sound->samples[voice.position * 2], length * 2,
+                                voice.gainLeft, voice.gainRight);
+                filled += length;
+                voice.position += length;
+                if (voice.position == voice.sound->frames) {
+                    voice.position = 0;
+                    if (!voice.loop) voice.sound = nullptr;
+                }
+            }
+        }
+        if (mixed) AddToStream(stream + done * 2, mixBlock, count * 2);
+        done += count;
+    }
+    int active = 0;
+    for (int i = 0; i < MIXER_MAX_VOICES; i++) {
+        bool playing = voices[i].sound != nullptr;
+        active += playing;
+        playingHandles[i].store(playing ? voices[i].handle : 0, std::memory_order_relaxed);
+    }
+    activeVoices.store(active, std::memory_order_relaxed);
+    // a voice the game thread sees as applied is already in playingHandles, or over
+    appliedHandle.store(lastPlayCommand, std::memory_order_release);
+}
+
+void SDLCALL AudioMixer::MixCallback(void *mixer, Uint8 *stream, int len) {
+    static_cast<AudioMixer*>(mixer)->Mix(reinterpret_cast<Sint16*>(stream), len / (int)(2 * sizeof(Sint16)));
+}
+
+bool AudioMixer::Send(const Command &command) {
+    if (commands.TryPush(command)) return true;
+    droppedCommands++;
+    return false;
+}
+
+void AudioMixer::ApplyCommands() {
+    Command command;
+    while (commands.TryPop(command)) {
+        switch (command.type) {
+            case COMMAND_PLAY: {
+                lastPlayCommand = command.voice;
+                // with every voice busy the new sound is dropped
+                Voice *voice = FindVoice(0);
+                if (voice == nullptr) break;
+                *voice = {command.sound, command.voice, 0, command.gainLeft, command.gainRight, command.loop};
+                break;
+            }
+            case COMMAND_STOP: {
+                Voice *voice = FindVoice(command.voice);
+                if (voice != nullptr) voice->sound = nullptr;
+                break;
+            }
+            case COMMAND_VOLUME: {
+                Voice *voice = FindVoice(command.voice);
+                if (voice == nullptr) break;
+                voice->gainLeft = command.gainLeft;
+                voice->gainRight = command.gainRight;
+                break;
+            }
+            case COMMAND_STOP_ALL:
+                for (Voice &voice : voices) voice.sound = nullptr;
+                break;
+        }
+    }
+}
+
+AudioMixer::Voice *AudioMixer::FindVoice(VoiceHandle handle) {
+    for (Voice &voice : voices) {
+        // handle 0 asks for a free voice
+        if (handle == 0 ? voice.sound == nullptr : (voice.sound != nullptr && voice.handle == handle)) return &voice;
+    }
+    return nullptr;
+}
+
+void AudioMixer::ToGains(float volume, float pan, float &gainLeft, float &gainRight) {
+    volume = std::min(std::max(volume, 0.0f), 1.0f);
+    pan = std::min(std::max(pan, -1.0f), 1.0f);
+    gainLeft = volume * (pan > 0 ? 1 - pan : 1);
+    gainRight = volume * (pan < 0 ? 1 + pan : 1);
+}
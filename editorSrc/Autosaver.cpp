@@ -0,0 +1,490 @@
+/**
+ * @file Autosaver.cpp
+ * @brief This file contains the background autosave of the level being edited.
+ */
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include "Autosaver.hpp"
+#include "LevelFile.hpp"
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <share.h>
+    #include <sys/stat.h>
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// number of tiles in a chunk
+const int CHUNK_TILES {TILE_CHUNK_SIZE * TILE_CHUNK_SIZE};
+
+std::string BasePath(const std::string &levelPath) {
+    return levelPath + ".autosave";
+}
+
+std::string JournalPath(const std::string &levelPath) {
+    return levelPath + ".autosave-journal";
+}
+
+bool FileExists(const std::string &path) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    std::fclose(file);
+    return true;
+}
+
+std::array<Uint32, 256> MakeCrc32Table() {
+    std::array<Uint32, 256> table;
+    for (Uint32 i = 0; i < 256; i++) {
+        Uint32 value = i;
+        for (int bit = 0; bit < 8; bit++) value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        table[i] = value;
+    }
+    return table;
+}
+
+// CRC32 as used by zip and png, continued from a previous value, 0 to start
+Uint32 Crc32(Uint32 crc, const void *data, size_t size) {
+    // built once, on whichever thread gets here first
+    static const std::array<Uint32, 256> table = MakeCrc32Table();
+    const Uint8 *bytes = static_cast<const Uint8*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+Uint32 RecordChecksum(AutosaveRecordHeader header, const void *payload) {
+    header.checksum = 0;
+    return Crc32(Crc32(0, &header, sizeof(header)), payload, header.payloadBytes);
+}
+
+// push written data past the OS cache, so it survives a crash or power loss
+bool SyncFile(FILE *file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool SyncPath(const std::string &path) {
+    FILE *file = std::fopen(path.c_str(), "r+b");
+    if (file == nullptr) return false;
+    bool synced = SyncFile(file);
+    std::fclose(file);
+    return synced;
+}
+
+// cut a file back to its first size bytes
+bool TruncateFile(const std::string &path, size_t size) {
+#ifdef _WIN32
+    int descriptor = -1;
+    if (_sopen_s(&descriptor, path.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) return false;
+    bool truncated = _chsize_s(descriptor, (__int64)size) == 0;
+    _close(descriptor);
+    return truncated;
+#else
+    return truncate(path.c_str(), (off_t)size) == 0;
+#endif
+}
+
+size_t FileSize(const std::string &path) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) return 0;
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    return size > 0 ? (size_t)size : 0;
+}
+
+// move a file over another one in a single step, readers see either the old or the new file
+bool ReplaceFile(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// find the newest committed record of every chunk in a journal, as the offset of its payload
+bool ScanJournal(const MappedFile &file, AutosaveJournalHeader &header, std::unordered_map<int, size_t> &newest) {
+    newest.clear();
+    const Uint8 *data = reinterpret_cast<const Uint8*>(file.Data());
+    size_t size = file.Size();
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, AUTOSAVE_JOURNAL_MAGIC, 4) != 0 || header.version != AUTOSAVE_JOURNAL_VERSION
+        || header.chunkSize != (Uint32)TILE_CHUNK_SIZE) return false;
+
+    Uint64 chunkCols = (header.width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    Uint64 chunkCount = chunkCols * ((header.height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE);
+    std::vector<std::pair<int, size_t>> pending;
+    size_t offset = sizeof(header);
+    AutosaveRecordHeader record;
+    // a crash can tear the last records, the scan stops at the first one that does not check out
+    while (offset + sizeof(record) <= size) {
+        std::memcpy(&record, data + offset, sizeof(record));
+        size_t payload = offset + sizeof(record);
+        if (std::memcmp(record.magic, AUTOSAVE_RECORD_MAGIC, 4) != 0 || record.payloadBytes > size - payload
+            || RecordChecksum(record, data + payload) != record.checksum) break;
+        if (record.type == RECORD_CHUNK && record.payloadBytes == CHUNK_TILES * sizeof(TileID)
+            && record.chunkIndex < chunkCount) {
+            pending.emplace_back((int)record.chunkIndex, payload);
+        } else if (record.type == RECORD_COMMIT) {
+            for (const auto &chunk : pending) newest[chunk.first] = chunk.second;
+            pending.clear();
+        }
+        offset = payload + record.payloadBytes;
+    }
+    if (!pending.empty()) SDL_Log("Dropped %d chunks of an unfinished autosave", (int)pending.size());
+    return true;
+}
+
+// apply the committed chunk records of a journal to a map
+void ReplayJournal(const std::string &journalPath, TileMap &map) {
+    MappedFile file;
+    if (!file.Open(journalPath)) return;
+    AutosaveJournalHeader header;
+    std::unordered_map<int, size_t> newest;
+    if (!ScanJournal(file, header, newest) || (int)header.width != map.GetWidth() || (int)header.height != map.GetHeight()) {
+        SDL_Log("%s does not belong to this level, ignoring it", journalPath.c_str());
+        return;
+    }
+    std::vector<TileID> tiles(CHUNK_TILES);
+    for (const auto &chunk : newest) {
+        std::memcpy(tiles.data(), file.Data() + chunk.second, CHUNK_TILES * sizeof(TileID));
+        int chunkX = chunk.first % map.GetChunkCols(), chunkY = chunk.first / map.GetChunkCols();
+        for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+            map.LoadRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                            &tiles[row * TILE_CHUNK_SIZE], TILE_CHUNK_SIZE);
+        }
+    }
+    map.Compact();
+}
+
+// whether a journal holds at least one committed chunk, a header alone is no autosave
+bool HasCommittedChunks(const std::string &journalPath) {
+    MappedFile file;
+    if (!FileExists(journalPath) || !file.Open(journalPath)) return false;
+    AutosaveJournalHeader header;
+    std::unordered_map<int, size_t> newest;
+    return ScanJournal(file, header, newest) && !newest.empty();
+}
+}
+
+Autosaver::Autosaver():width(0),height(0),journal(nullptr),journalBytes(0),committedBatches(0),
+                       compactThreshold(AUTOSAVE_COMPACT_BYTES),sequence(0),running(false),stopping(false) {
+}
+
+Autosaver::~Autosaver() {
+    Stop();
+}
+
+void Autosaver::Start(const std::string &levelPath, const TileMap &map) {
+    Stop();
+    this->levelPath = levelPath;
+    width = map.GetWidth();
+    height = map.GetHeight();
+    savedVersions.resize(map.GetChunkCols() * map.GetChunkRows());
+    for (int chunkY = 0; chunkY < map.GetChunkRows(); chunkY++) {
+        for (int chunkX = 0; chunkX < map.GetChunkCols(); chunkX++) {
+            savedVersions[chunkY * map.GetChunkCols() + chunkX] = map.GetChunkEditVersion(chunkX, chunkY);
+        }
+    }
+    unsavedChunks.clear();
+    lastSave = std::chrono::steady_clock::now();
+    stopping = false;
+    running = true;
+    worker = std::thread(&Autosaver::WorkerLoop, this);
+}
+
+void Autosaver::Update(const TileMap &map) {
+    if (!IsRunning()) return;
+    std::chrono::duration<double> sinceSave = std::chrono::steady_clock::now() - lastSave;
+    if (sinceSave.count() < AUTOSAVE_INTERVAL_SECONDS) return;
+    Flush(map);
+}
+
+void Autosaver::Flush(const TileMap &map) {
+    if (!IsRunning()) return;
+    lastSave = std::chrono::steady_clock::now();
+    if ((int)savedVersions.size() != map.GetChunkCols() * map.GetChunkRows()) return;
+    {
+        // chunks the worker could not write count as unsaved again, so they are sent once more
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int chunkIndex : unsavedChunks) {
+            int chunkX = chunkIndex % map.GetChunkCols(), chunkY = chunkIndex / map.GetChunkCols();
+            savedVersions[chunkIndex] = ~map.GetChunkEditVersion(chunkX, chunkY);
+        }
+        unsavedChunks.clear();
+    }
+
+    // copying the edited chunks is all the main thread does
+    Batch batch;
+    std::vector<unsigned int> versions;
+    for (int chunkY = 0; chunkY < map.GetChunkRows(); chunkY++) {
+        for (int chunkX = 0; chunkX < map.GetChunkCols(); chunkX++) {
+            int chunkIndex = chunkY * map.GetChunkCols() + chunkX;
+            unsigned int version = map.GetChunkEditVersion(chunkX, chunkY);
+            // an absent chunk reads as empty, its edits are saved once it is back in the map
+            if (version == savedVersions[chunkIndex] || map.IsChunkAbsent(chunkX, chunkY)) continue;
+            versions.push_back(version);
+            batch.chunkIndices.push_back(chunkIndex);
+            size_t offset = batch.tiles.size();
+            batch.tiles.resize(offset + CHUNK_TILES);
+            for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+                map.CopyRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                                &batch.tiles[offset + row * TILE_CHUNK_SIZE], TILE_CHUNK_SIZE);
+            }
+        }
+    }
+    if (batch.chunkIndices.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        // the chunks only count as saved once the worker has them
+        for (size_t i = 0; i < versions.size(); i++) savedVersions[batch.chunkIndices[i]] = versions[i];
+        batches.push_back(std::move(batch));
+    }
+    wakeWorker.notify_one();
+}
+
+void Autosaver::Stop() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorker.notify_one();
+    worker.join();
+    running = false;
+}
+
+bool Autosaver::IsChunkSaved(const TileMap &map, int chunkX, int chunkY) const {
+    if (!IsRunning()) return true;
+    int chunkIndex = chunkY * map.GetChunkCols() + chunkX;
+    if (chunkIndex >= (int)savedVersions.size()) return false;
+    return savedVersions[chunkIndex] == map.GetChunkEditVersion(chunkX, chunkY);
+}
+
+bool Autosaver::HasAutosave(const std::string &levelPath) {
+    return FileExists(BasePath(levelPath)) || HasCommittedChunks(JournalPath(levelPath));
+}
+
+bool Autosaver::Recover(const std::string &levelPath, TileMap &map) {
+    std::string basePath = BasePath(levelPath);
+    if (!map.LoadFromFile(FileExists(basePath) ? basePath : levelPath)) return false;
+    ReplayJournal(JournalPath(levelPath), map);
+    return true;
+}
+
+void Autosaver::Discard(const std::string &levelPath) {
+    std::remove(JournalPath(levelPath).c_str());
+    std::remove(BasePath(levelPath).c_str());
+}
+
+void Autosaver::WorkerLoop() {
+    sequence = 0;
+    compactThreshold = AUTOSAVE_COMPACT_BYTES;
+    // an old journal may end in a torn record, fold it into the base instead of appending to it
+    if (FileExists(JournalPath(levelPath)) && !Compact()) {
+        SDL_Log("Autosave of %s is disabled", levelPath.c_str());
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        running = false;
+        batches.clear();
+        return;
+    }
+
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorker.wait(lock, [this] { return stopping || !batches.empty(); });
+            // batches handed over before Stop() are still written
+            if (batches.empty()) break;
+            batch = std::move(batches.front());
+            batches.pop_front();
+        }
+        // the journal is only created once there is something to put in it
+        if (journal == nullptr && !OpenJournal()) {
+            SDL_Log("Autosave journal of %s could not be created", levelPath.c_str());
+            ReturnChunks(batch);
+            continue;
+        }
+        size_t batchStart = journalBytes;
+        if (WriteBatch(batch)) {
+            committedBatches++;
+        } else {
+            SDL_Log("Autosave of %s failed", levelPath.c_str());
+            ReturnChunks(batch);
+            // a torn record hides every batch after it from recovery, cut it off or fold the
+            // committed records before it into the base
+            CloseJournal();
+            if (TruncateFile(JournalPath(levelPath), batchStart)) {
+                journalBytes = batchStart;
+            } else if (!Compact()) {
+                SDL_Log("Autosave of %s is disabled", levelPath.c_str());
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                running = false;
+                batches.clear();
+                return;
+            }
+        }
+        if (journalBytes > compactThreshold) {
+            if (Compact()) {
+                compactThreshold = AUTOSAVE_COMPACT_BYTES;
+            } else {
+                // a failing disk would otherwise rewrite the whole level every interval
+                SDL_Log("Compacting the autosave of %s failed", levelPath.c_str());
+                compactThreshold = journalBytes + AUTOSAVE_COMPACT_BYTES;
+            }
+        }
+    }
+    CloseJournal();
+    // a journal without a single committed batch is no autosave, leave nothing behind
+    if (committedBatches == 0) std::remove(JournalPath(levelPath).c_str());
+}
+
+bool Autosaver::WriteBatch(const Batch &batch) {
+    if (journal == nullptr) return false;
+    bool written = true;
+    auto writeRecord = [&](Uint32 type, Uint32 chunkIndex, const void *payload, Uint32 payloadBytes) {
+        AutosaveRecordHeader record;
+        std::memcpy(record.magic, AUTOSAVE_RECORD_MAGIC, 4);
+        record.type = type;
+        record.sequence = sequence;
+        record.chunkIndex = chunkIndex;
+        record.payloadBytes = payloadBytes;
+        record.checksum = RecordChecksum(record, payload);
+        written = written && std::fwrite(&record, sizeof(record), 1, journal) == 1
+            && (payloadBytes == 0 || std::fwrite(payload, payloadBytes, 1, journal) == 1);
+        journalBytes += sizeof(record) + payloadBytes;
+    };
+    for (size_t i = 0; i < batch.chunkIndices.size(); i++) {
+        writeRecord(RECORD_CHUNK, batch.chunkIndices[i], &batch.tiles[i * CHUNK_TILES], CHUNK_TILES * sizeof(TileID));
+    }
+    // only a batch followed by its commit record is replayed
+    writeRecord(RECORD_COMMIT, 0, nullptr, 0);
+    sequence++;
+    return written && SyncFile(journal);
+}
+
+bool Autosaver::Compact() {
+    CloseJournal();
+    std::string basePath = BasePath(levelPath);
+    std::string journalPath = JournalPath(levelPath);
+    std::string tempPath = basePath + ".tmp";
+    {
+        MappedFile journalFile;
+        AutosaveJournalHeader header;
+        std::unordered_map<int, size_t> newest;
+        // a journal that cannot be replayed adds nothing to the base
+        if (!journalFile.Open(journalPath) || !ScanJournal(journalFile, header, newest) || newest.empty()) {
+            journalFile.Close();
+            committedBatches = 0;
+            return std::remove(journalPath.c_str()) == 0;
+        }
+
+        // the chunks the journal does not have come from the base, or from the level if there is none
+        std::string sourcePath = FileExists(basePath) ? basePath : levelPath;
+        LevelFile source;
+        TileMap textSource;
+        bool streamed = LevelFile::IsLevelFile(sourcePath) && source.Open(sourcePath)
+            && source.GetChunkSize() == TILE_CHUNK_SIZE;
+        if (!streamed) {
+            // text levels, and binary ones of another chunk size, are only held for the compaction
+            source.Close();
+            textSource.SetStorage(STORAGE_SPARSE);
+            if (!textSource.LoadFromFile(sourcePath)) return false;
+        }
+        int sourceWidth = streamed ? source.GetWidth() : textSource.GetWidth();
+        int sourceHeight = streamed ? source.GetHeight() : textSource.GetHeight();
+        if ((int)header.width != sourceWidth || (int)header.height != sourceHeight) {
+            SDL_Log("%s does not belong to this level, ignoring it", journalPath.c_str());
+            journalFile.Close();
+            committedBatches = 0;
+            return std::remove(journalPath.c_str()) == 0;
+        }
+
+        int chunkCols = (sourceWidth + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+        auto readChunk = [&](int chunkX, int chunkY, TileID *out) {
+            auto found = newest.find(chunkY * chunkCols + chunkX);
+            if (found != newest.end()) {
+                std::memcpy(out, journalFile.Data() + found->second, CHUNK_TILES * sizeof(TileID));
+                return true;
+            }
+            if (streamed) return source.DecodeChunk(chunkX, chunkY, out);
+            for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+                textSource.CopyRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                                       out + row * TILE_CHUNK_SIZE, TILE_CHUNK_SIZE);
+            }
+            return true;
+        };
+        if (!LevelFile::Write(sourceWidth, sourceHeight, readChunk, tempPath, true) || !SyncPath(tempPath)) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        // the base may be the source, its mapping has to go before it is replaced
+    }
+    // a crash before the rename leaves the old base and journal in place, one after it
+    // leaves the new base with the old journal, whose records it already contains
+    if (!ReplaceFile(tempPath, basePath)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    committedBatches = 0;
+    return std::remove(journalPath.c_str()) == 0;
+}
+
+bool Autosaver::OpenJournal() {
+    std::string journalPath = JournalPath(levelPath);
+    // a journal of this session that was closed after a failure holds records, append to it
+    if (!FileExists(journalPath)) return StartJournal();
+    journalBytes = FileSize(journalPath);
+    journal = std::fopen(journalPath.c_str(), "ab");
+    return journal != nullptr;
+}
+
+void Autosaver::ReturnChunks(const Batch &batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    unsavedChunks.insert(unsavedChunks.end(), batch.chunkIndices.begin(), batch.chunkIndices.end());
+}
+
+bool Autosaver::StartJournal() {
+    CloseJournal();
+    std::string journalPath = JournalPath(levelPath);
+    std::string tempPath = journalPath + ".tmp";
+
+    AutosaveJournalHeader header;
+    std::memcpy(header.magic, AUTOSAVE_JOURNAL_MAGIC, 4);
+    header.version = AUTOSAVE_JOURNAL_VERSION;
+    header.width = width;
+    header.height = height;
+    header.chunkSize = TILE_CHUNK_SIZE;
+    FILE *file = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) return false;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 && SyncFile(file);
+    std::fclose(file);
+    if (!written || !ReplaceFile(tempPath, journalPath)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    journal = std::fopen(journalPath.c_str(), "ab");
+    journalBytes = sizeof(header);
+    committedBatches = 0;
+    return journal != nullptr;
+}
+
+void Autosaver::CloseJournal() {
+    if (journal != nullptr) std::fclose(journal);
+    journal = nullptr;
+}
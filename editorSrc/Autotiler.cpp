@@ -0,0 +1,86 @@
+/**
+ * @file Autotiler.cpp
+ * @brief This file contains the autotiler that picks edge and corner tiles for painted terrain.
+ */
+#include <algorithm>
+#include "Autotiler.hpp"
+
+Autotiler::Autotiler(const AutotileTable &table):table(table) {
+    for (TileID id : table) {
+        if (id < 0) continue;
+        if (id >= (int)terrainIds.size()) terrainIds.resize(id + 1, false);
+        terrainIds[id] = true;
+    }
+}
+
+Autotiler::~Autotiler() {
+}
+
+bool Autotiler::IsTerrain(TileID id) const {
+    return id >= 0 && id < (int)terrainIds.size() && terrainIds[id];
+}
+
+void Autotiler::Paint(TileMap &map, int x, int y, bool terrain) {
+    if (!map.InBounds(x, y)) return;
+    if (IsTerrain(map.GetTile(x, y)) != terrain) {
+        map.SetTile(x, y, terrain ? table[0xFF] : EMPTY_TILE);
+    }
+    Retile(map, {x - 1, y - 1, 3, 3});
+}
+
+void Autotiler::PaintRect(TileMap &map, const SDL_Rect &area, bool terrain) {
+    int firstX = std::max(0, area.x), lastX = std::min(map.GetWidth(), area.x + area.w);
+    int firstY = std::max(0, area.y), lastY = std::min(map.GetHeight(), area.y + area.h);
+    if (firstX >= lastX || firstY >= lastY) return;
+    // the tiles written here are placeholders, retiling picks the real ones
+    retiledIds.assign(lastX - firstX, terrain ? table[0xFF] : EMPTY_TILE);
+    for (int y = firstY; y < lastY; y++) {
+        map.SetRowSpan(firstX, y, retiledIds.data(), lastX - firstX);
+    }
+    Retile(map, {firstX - 1, firstY - 1, lastX - firstX + 2, lastY - firstY + 2});
+}
+
+void Autotiler::Retile(TileMap &map, const SDL_Rect &area, TileChangeSet *changes) {
+    int firstX = std::max(0, area.x), lastX = std::min(map.GetWidth(), area.x + area.w);
+    int firstY = std::max(0, area.y), lastY = std::min(map.GetHeight(), area.y + area.h);
+    int count = lastX - firstX;
+    if (count <= 0 || firstY >= lastY) return;
+
+    // three rows of terrain flags roll down the area, each read once
+    ReadRow(map, firstY - 1, firstX, count, above);
+    ReadRow(map, firstY, firstX, count, row);
+    for (int y = firstY; y < lastY; y++) {
+        ReadRow(map, y + 1, firstX, count, below);
+        rowIds.resize(count);
+        map.CopyRowSpan(firstX, y, rowIds.data(), count);
+        retiledIds = rowIds;
+        for (int i = 0; i < count; i++) {
+            // flag index i + 1 is the cell, i and i + 2 its neighbours to the left and right
+            if (!row[i + 1]) continue;
+            int mask = (above[i + 1] ? NEIGHBOUR_N : 0) | (above[i + 2] ? NEIGHBOUR_NE : 0)
+                     | (row[i + 2] ? NEIGHBOUR_E : 0) | (below[i + 2] ? NEIGHBOUR_SE : 0)
+                     | (below[i + 1] ? NEIGHBOUR_S : 0) | (below[i] ? NEIGHBOUR_SW : 0)
+                     | (row[i] ? NEIGHBOUR_W : 0) | (above[i] ? NEIGHBOUR_NW : 0);
+            retiledIds[i] = table[mask];
+        }
+        // rewriting an unchanged row would still bump its chunk versions
+        if (retiledIds != rowIds) {
+            map.SetRowSpan(firstX, y, retiledIds.data(), count);
+            if (changes != nullptr) changes->AddSpan(map.GetChunkCols(), firstX, y, count);
+        }
+        std::swap(above, row);
+        std::swap(row, below);
+    }
+}
+
+void Autotiler::ReadRow(const TileMap &map, int y, int x, int count, std::vector<Uint8> &out) {
+    out.assign(count + 2, 1);
+    // cells outside of the map count as terrain, so the map border gets no edge tiles
+    if (y < 0 || y >= map.GetHeight()) return;
+    rowIds.resize(count + 2);
+    map.CopyRowSpan(x - 1, y, rowIds.data(), count + 2);
+    for (int i = 0; i < count + 2; i++) {
+        int tileX = x - 1 + i;
+        if (tileX >= 0 && tileX < map.GetWidth()) out[i] = IsTerrain(rowIds[i]);
+    }
+}
@@ -0,0 +1,157 @@
+/**
+ * @file Benchmarks.cpp
+ * @brief This file contains the benchmarks that can be started from the command line.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "Benchmarks.hpp"
+#include "AudioMixer.hpp"
+#include "LevelTextParser.hpp"
+#include "TileMap.hpp"
+#include "VoiceManager.hpp"
+
+namespace {
+
+// the loader TileMap used before LevelTextParser: one getline and istringstream per row
+bool LoadLevelWithStreams(const std::string &filePath, TileMap &map) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) return false;
+    std::vector<std::vector<TileID>> rows;
+    std::string line;
+    size_t columns = 0;
+    while (std::getline(file, line)) {
+        std::istringstream lineStream(line);
+        std::vector<TileID> row;
+        int id;
+        while (lineStream >> id) row.push_back((TileID)id);
+        if (row.empty()) continue;
+        columns = std::max(columns, row.size());
+        rows.push_back(row);
+    }
+    map.Resize((int)columns, (int)rows.size());
+    for (int y = 0; y < map.GetHeight(); y++) {
+        map.SetRowSpan(0, y, rows[y].data(), (int)rows[y].size());
+    }
+    return true;
+}
+
+bool SameTiles(const TileMap &a, const TileMap &b) {
+    if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight()) return false;
+    std::vector<TileID> rowA(a.GetWidth()), rowB(b.GetWidth());
+    for (int y = 0; y < a.GetHeight(); y++) {
+        a.CopyRowSpan(0, y, rowA.data(), a.GetWidth());
+        b.CopyRowSpan(0, y, rowB.data(), b.GetWidth());
+        if (rowA != rowB) return false;
+    }
+    return true;
+}
+
+template<typename Function>
+double TimeMilliseconds(Function function) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}
+
+int RunLevelParserBenchmark(int size) {
+    const std::string filePath = "level-parser-bench.tmp";
+    std::cout << "Generating a " << size << "x" << size << " level..." << std::endl;
+    {
+        // mostly empty like the shipped levels, with runs of ground tiles
+        TileMap generated(size, size);
+        srand(1234);
+        std::vector<TileID> row(size);
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                row[x] = (rand() % 8 == 0) ? (TileID)(rand() % 256) : EMPTY_TILE;
+            }
+            generated.SetRowSpan(0, y, row.data(), size);
+        }
+        if (!generated.SaveToFile(filePath)) {
+            std::cout << "Failed to write " << filePath << std::endl;
+            return 1;
+        }
+    }
+
+    TileMap streamMap, singleMap, parallelMap;
+    LevelTextParser singleParser, parallelParser;
+    singleParser.SetThreadCount(1);
+    double streamTime = TimeMilliseconds([&]() { LoadLevelWithStreams(filePath, streamMap); });
+    double singleTime = TimeMilliseconds([&]() { singleParser.ParseFile(filePath, singleMap); });
+    double parallelTime = TimeMilliseconds([&]() { parallelParser.ParseFile(filePath, parallelMap); });
+    std::remove(filePath.c_str());
+
+    std::cout << "istream >> int:            " << streamTime << " ms" << std::endl;
+    std::cout << "from_chars, 1 thread:      " << singleTime << " ms ("
+              << streamTime / singleTime << "x)" << std::endl;
+    std::cout << "from_chars, " << std::max(1u, std::thread::hardware_concurrency()) << " threads:     "
+              << parallelTime << " ms (" << streamTime / parallelTime << "x)" << std::endl;
+
+    if (!SameTiles(streamMap, singleMap) || !SameTiles(streamMap, parallelMap)) {
+        std::cout << "Loaders disagree on the level contents!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int RunVoiceBenchmark(int entities) {
+    const int updates = UPDATES_PER_SECOND * 10;
+    // each entity kind has a footstep of its own, together they ask for more voices than the budget
+    const int kinds = 8;
+    AudioMixer mixer;
+    VoiceManager voiceManager;
+    voiceManager.SetMixer(&mixer);
+    std::vector<SoundID> steps(kinds);
+    for (int kind = 0; kind < kinds; kind++) {
+        steps[kind] = mixer.AddTone(110.0f * (kind + 2), 0.25f);
+        voiceManager.SetSoundRules(steps[kind], kind % 2, VOICE_DEFAULT_INSTANCES);
+    }
+
+    // the entities start spread over twice the audible distance around the listener at 0, 0
+    struct Entity {
+        int x;
+        int y;
+    };
+    srand(1234);
+    std::vector<Entity> crowd(entities);
+    for (Entity &entity : crowd) {
+        entity.x = rand() % (4 * VOICE_AUDIBLE_DISTANCE) - 2 * VOICE_AUDIBLE_DISTANCE;
+        entity.y = rand() % (4 * VOICE_AUDIBLE_DISTANCE) - 2 * VOICE_AUDIBLE_DISTANCE;
+    }
+    // one update worth of audio is mixed after every update
+    const int framesPerUpdate = AUDIO_FREQUENCY / UPDATES_PER_SECOND;
+    std::vector<Sint16> stream(framesPerUpdate * 2);
+
+    std::cout << entities << " entities triggering a sound every update for " << updates << " updates..." << std::endl;
+    int peakVoices = 0, peakMixerVoices = 0;
+    double voiceTime = 0;
+    for (int update = 0; update < updates; update++) {
+        voiceTime += TimeMilliseconds([&]() {
+            for (int i = 0; i < entities; i++) {
+                crowd[i].x += rand() % 9 - 4;
+                crowd[i].y += rand() % 9 - 4;
+                voiceManager.Trigger(steps[i % kinds], crowd[i].x, crowd[i].y, 0.5f);
+            }
+            voiceManager.Update();
+        });
+        peakVoices = std::max(peakVoices, voiceManager.GetActiveVoices());
+        std::fill(stream.begin(), stream.end(), 0);
+        mixer.Mix(stream.data(), framesPerUpdate);
+        peakMixerVoices = std::max(peakMixerVoices, mixer.GetActiveVoices());
+    }
+
+    Uint64 triggers = (Uint64)entities * updates;
+    std::cout << "triggers:            " << triggers << std::endl;
+    std::cout << "coalesced:           " << voiceManager.GetCoalescedTriggers() << std::endl;
+    std::cout << "culled:              " << voiceManager.GetCulledVoices() << std::endl;
+    std::cout << "peak voices:         " << peakVoices << " of " << VOICE_BUDGET << " (mixer "
+              << peakMixerVoices << " of " << MIXER_MAX_VOICES << ")" << std::endl;
+    std::cout << "dropped commands:    " << mixer.GetDroppedCommands() << std::endl;
+    std::cout << "triggers and update: " << voiceTime / updates * 1000.0 << " us per update" << std::endl;
+    return peakVoices <= VOICE_BUDGET && peakMixerVoices <= VOICE_BUDGET ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file Camera.cpp
+ * @brief This file contains the camera that decides which part of the level is on screen.
+ */
+#include <algorithm>
+#include "Camera.hpp"
+
+Camera::Camera():view{0, 0, 0, 0},levelWidth(0),levelHeight(0) {
+}
+
+Camera::Camera(int viewportWidth, int viewportHeight):view{0, 0, viewportWidth, viewportHeight},
+    levelWidth(0),levelHeight(0) {
+}
+
+Camera::~Camera() {
+}
+
+void Camera::SetViewport(int viewportWidth, int viewportHeight) {
+    view.w = viewportWidth;
+    view.h = viewportHeight;
+    Clamp();
+}
+
+void Camera::SetBounds(int levelWidth, int levelHeight) {
+    this->levelWidth = levelWidth;
+    this->levelHeight = levelHeight;
+    Clamp();
+}
+
+void Camera::SetPosition(int x, int y) {
+    view.x = x;
+    view.y = y;
+    Clamp();
+}
+
+void Camera::Move(int dx, int dy) {
+    SetPosition(view.x + dx, view.y + dy);
+}
+
+void Camera::CenterOn(int x, int y) {
+    SetPosition(x - view.w / 2, y - view.h / 2);
+}
+
+bool Camera::IsVisible(const SDL_Rect &rect) const {
+    return rect.x < view.x + view.w && rect.x + rect.w > view.x
+        && rect.y < view.y + view.h && rect.y + rect.h > view.y;
+}
+
+SDL_Rect Camera::ToScreen(const SDL_Rect &rect) const {
+    return {rect.x - view.x, rect.y - view.y, rect.w, rect.h};
+}
+
+TileRange Camera::GetVisibleRange(int tileSize, int cols, int rows) const {
+    TileRange range;
+    range.firstX = std::max(0, FloorDiv(view.x, tileSize));
+    range.firstY = std::max(0, FloorDiv(view.y, tileSize));
+    range.lastX = std::min(cols - 1, FloorDiv(view.x + view.w - 1, tileSize));
+    range.lastY = std::min(rows - 1, FloorDiv(view.y + view.h - 1, tileSize));
+    return range;
+}
+
+void Camera::Clamp() {
+    // a level smaller than the viewport stays pinned to the top left corner
+    if (levelWidth > 0) view.x = std::max(0, std::min(view.x, levelWidth - view.w));
+    if (levelHeight > 0) view.y = std::max(0, std::min(view.y, levelHeight - view.h));
+}
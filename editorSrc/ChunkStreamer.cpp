@@ -0,0 +1,295 @@
+/**
+ * @file ChunkStreamer.cpp
+ * @brief This file contains the pager that keeps only the chunks around the camera in memory.
+ */
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include "ChunkStreamer.hpp"
+
+// chunks stay resident this many chunks past the request radius, so a camera
+// moving back and forth over a chunk border does not page the same chunks in and out
+const int STREAM_EVICT_MARGIN {1};
+// weight of the newest frame in the smoothed camera velocity
+const double VELOCITY_SMOOTHING {0.2};
+// spillSlots entry of a chunk that was never spilled
+const Uint32 NO_SPILL_SLOT {0xFFFFFFFF};
+// bytes of one chunk in the spill file
+const size_t SPILL_SLOT_BYTES {TILE_CHUNK_SIZE * TILE_CHUNK_SIZE * sizeof(TileID)};
+
+ChunkStreamer::ChunkStreamer():tileMap(nullptr),autosaver(nullptr),residentRadius(STREAM_RESIDENT_RADIUS),
+    cameraChunkX(0),cameraChunkY(0),predictedChunkX(0),predictedChunkY(0),
+    velocityX(0),velocityY(0),lastCenterX(0),lastCenterY(0),hasLastUpdate(false),
+    chunkStates(GetLevelArena()),storedEditVersions(GetLevelArena()),spillSlots(GetLevelArena()),
+    stopping(false),spillFile(nullptr),spillCount(0) {
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    Close();
+}
+
+bool ChunkStreamer::Open(const std::string &filePath, TileMap *map) {
+    Close();
+    if (!level.Open(filePath)) return false;
+    if (level.GetChunkSize() != TILE_CHUNK_SIZE) {
+        SDL_Log("%s uses %d tile chunks, streaming needs %d", filePath.c_str(), level.GetChunkSize(), TILE_CHUNK_SIZE);
+        level.Close();
+        return false;
+    }
+    tileMap = map;
+    tileMap->Resize(level.GetWidth(), level.GetHeight());
+    // chunks with tiles in the file take no edits until they are installed, loading them would overwrite the edits
+    for (int chunkY = 0; chunkY < level.GetChunkRows(); chunkY++) {
+        for (int chunkX = 0; chunkX < level.GetChunkCols(); chunkX++) {
+            if (level.GetChunkEncoding(chunkX, chunkY) != CHUNK_EMPTY) tileMap->SetChunkAbsent(chunkX, chunkY, true);
+        }
+    }
+    int chunkCount = level.GetChunkCols() * level.GetChunkRows();
+    chunkStates.assign(chunkCount, CHUNK_NOT_RESIDENT);
+    // Resize() started every edit version at 0, the level holds that version of each chunk
+    storedEditVersions.assign(chunkCount, 0);
+    spillSlots.assign(chunkCount, NO_SPILL_SLOT);
+    spillPath = filePath + ".stream-spill";
+    spillCount = 0;
+    residentChunks.clear();
+    hasLastUpdate = false;
+    velocityX = velocityY = 0;
+    stopping = false;
+    worker = std::thread(&ChunkStreamer::WorkerLoop, this);
+    return true;
+}
+
+void ChunkStreamer::Close() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            requests.clear();
+        }
+        wakeWorker.notify_one();
+        worker.join();
+    }
+    results.clear();
+    installing.clear();
+    // the tables stop using the level arena, so it can be released with the level
+    chunkStates.clear();
+    chunkStates.shrink_to_fit();
+    storedEditVersions.clear();
+    storedEditVersions.shrink_to_fit();
+    spillSlots.clear();
+    spillSlots.shrink_to_fit();
+    if (spillFile != nullptr) {
+        std::fclose(spillFile);
+        spillFile = nullptr;
+        std::remove(spillPath.c_str());
+    }
+    spillCount = 0;
+    level.Close();
+    tileMap = nullptr;
+}
+
+void ChunkStreamer::SetResidentRadius(int radius) {
+    residentRadius = std::max(0, radius);
+}
+
+void ChunkStreamer::Update(const SDL_Rect &view) {
+    if (tileMap == nullptr) return;
+    const int chunkPixels = TILE_CHUNK_SIZE * TILE_SIZE;
+    const int chunkCols = level.GetChunkCols();
+
+    // 1. estimate where the camera is heading
+    double centerX = view.x + view.w / 2.0;
+    double centerY = view.y + view.h / 2.0;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (hasLastUpdate) {
+        double seconds = std::chrono::duration<double>(now - lastUpdate).count();
+        if (seconds > 0) {
+            velocityX += VELOCITY_SMOOTHING * ((centerX - lastCenterX) / seconds - velocityX);
+            velocityY += VELOCITY_SMOOTHING * ((centerY - lastCenterY) / seconds - velocityY);
+        }
+    }
+    hasLastUpdate = true;
+    lastUpdate = now;
+    lastCenterX = centerX;
+    lastCenterY = centerY;
+    cameraChunkX = (int)(centerX / chunkPixels);
+    cameraChunkY = (int)(centerY / chunkPixels);
+    predictedChunkX = (int)((centerX + velocityX * STREAM_PREFETCH_SECONDS) / chunkPixels);
+    predictedChunkY = (int)((centerY + velocityY * STREAM_PREFETCH_SECONDS) / chunkPixels);
+
+    // 2. install a bounded number of finished chunks, the rest wait for the next frame
+    // the containers of this step and step 4 allocate nothing from the heap in steady state
+    installing.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        installing.swap(results);
+    }
+    int installed = 0;
+    ArenaVector<LoadedChunk> postponed(GetFrameArena());
+    postponed.reserve(installing.size());
+    for (LoadedChunk &chunk : installing) {
+        if (!InRange(chunk.chunkIndex, residentRadius + STREAM_EVICT_MARGIN)) {
+            // the camera moved on while the chunk was read
+            chunkStates[chunk.chunkIndex] = CHUNK_NOT_RESIDENT;
+            continue;
+        }
+        if (installed == STREAM_MAX_INSTALLS_PER_FRAME) {
+            postponed.push_back(std::move(chunk));
+            continue;
+        }
+        installed++;
+        int chunkX = chunk.chunkIndex % chunkCols;
+        int chunkY = chunk.chunkIndex / chunkCols;
+        for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+            tileMap->LoadRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                                &chunk.tiles[row * TILE_CHUNK_SIZE], TILE_CHUNK_SIZE);
+        }
+        tileMap->SetChunkAbsent(chunkX, chunkY, false);
+        chunkStates[chunk.chunkIndex] = CHUNK_RESIDENT;
+        residentChunks.push_back(chunk.chunkIndex);
+    }
+    if (!postponed.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.insert(results.begin(), std::make_move_iterator(postponed.begin()),
+                       std::make_move_iterator(postponed.end()));
+    }
+
+    // 3. page out chunks that are out of range, edited ones to the spill file once the autosave has them
+    for (size_t i = 0; i < residentChunks.size(); ) {
+        int chunkIndex = residentChunks[i];
+        int chunkX = chunkIndex % chunkCols;
+        int chunkY = chunkIndex / chunkCols;
+        if (InRange(chunkIndex, residentRadius + STREAM_EVICT_MARGIN)) {
+            i++;
+            continue;
+        }
+        unsigned int editVersion = tileMap->GetChunkEditVersion(chunkX, chunkY);
+        if (editVersion != storedEditVersions[chunkIndex]) {
+            if ((autosaver != nullptr && !autosaver->IsChunkSaved(*tileMap, chunkX, chunkY)) || !SpillChunk(chunkIndex)) {
+                i++;
+                continue;
+            }
+            storedEditVersions[chunkIndex] = editVersion;
+        }
+        // chunks empty in the level and never spilled hold nothing to drop
+        if (HasStoredTiles(chunkIndex)) {
+            tileMap->ClearChunk(chunkX, chunkY);
+            tileMap->SetChunkAbsent(chunkX, chunkY, true);
+        }
+        chunkStates[chunkIndex] = CHUNK_NOT_RESIDENT;
+        residentChunks[i] = residentChunks.back();
+        residentChunks.pop_back();
+    }
+
+    // 4. request what is missing around the camera first, then around the predicted position.
+    // Requests from earlier frames that were not taken yet are replaced; chunks the worker
+    // is reading or has finished stay CHUNK_REQUESTED until they are installed or discarded.
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int chunkIndex : requests) chunkStates[chunkIndex] = CHUNK_NOT_RESIDENT;
+    ArenaVector<int> wanted(GetFrameArena());
+    wanted.reserve(2 * (2 * residentRadius + 1) * (2 * residentRadius + 1));
+    auto want = [&](int centerChunkX, int centerChunkY) {
+        for (int chunkY = centerChunkY - residentRadius; chunkY <= centerChunkY + residentRadius; chunkY++) {
+            for (int chunkX = centerChunkX - residentRadius; chunkX <= centerChunkX + residentRadius; chunkX++) {
+                if (chunkX < 0 || chunkY < 0 || chunkX >= chunkCols || chunkY >= level.GetChunkRows()) continue;
+                int chunkIndex = chunkY * chunkCols + chunkX;
+                if (chunkStates[chunkIndex] != CHUNK_NOT_RESIDENT) continue;
+                // nothing to read for chunks stored nowhere, they are resident as they are,
+                // so that edits to them are paged out like any others
+                if (!HasStoredTiles(chunkIndex)) {
+                    chunkStates[chunkIndex] = CHUNK_RESIDENT;
+                    residentChunks.push_back(chunkIndex);
+                    continue;
+                }
+                chunkStates[chunkIndex] = CHUNK_REQUESTED;
+                wanted.push_back(chunkIndex);
+            }
+        }
+    };
+    want(cameraChunkX, cameraChunkY);
+    want(predictedChunkX, predictedChunkY);
+    std::stable_sort(wanted.begin(), wanted.end(), [&](int a, int b) {
+        int distanceA = std::max(std::abs(a % chunkCols - cameraChunkX), std::abs(a / chunkCols - cameraChunkY));
+        int distanceB = std::max(std::abs(b % chunkCols - cameraChunkX), std::abs(b / chunkCols - cameraChunkY));
+        return distanceA < distanceB;
+    });
+    requests.assign(wanted.begin(), wanted.end());
+    lock.unlock();
+    if (!wanted.empty()) wakeWorker.notify_one();
+}
+
+void ChunkStreamer::WorkerLoop() {
+    const int chunkCols = level.GetChunkCols();
+    while (true) {
+        int chunkIndex;
+        Uint32 spillSlot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorker.wait(lock, [this]() { return stopping || !requests.empty(); });
+            if (stopping) return;
+            chunkIndex = requests.front();
+            requests.pop_front();
+            // the slot was assigned before the chunk was requested
+            spillSlot = spillSlots[chunkIndex];
+        }
+        // touching the mapped pages here is what reads them from disk
+        LoadedChunk chunk;
+        chunk.chunkIndex = chunkIndex;
+        chunk.tiles.resize(TILE_CHUNK_SIZE * TILE_CHUNK_SIZE);
+        if (spillSlot != NO_SPILL_SLOT) {
+            if (!ReadSpilledChunk(spillSlot, chunk.tiles.data())) {
+                SDL_Log("Spilled chunk %d could not be read back", chunkIndex);
+                std::fill(chunk.tiles.begin(), chunk.tiles.end(), EMPTY_TILE);
+            }
+        } else if (!level.DecodeChunk(chunkIndex % chunkCols, chunkIndex / chunkCols, chunk.tiles.data())) {
+            SDL_Log("Chunk %d of the streamed level is broken", chunkIndex);
+            std::fill(chunk.tiles.begin(), chunk.tiles.end(), EMPTY_TILE);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(chunk));
+    }
+}
+
+bool ChunkStreamer::InRange(int chunkIndex, int radius) const {
+    int chunkX = chunkIndex % level.GetChunkCols();
+    int chunkY = chunkIndex / level.GetChunkCols();
+    bool nearCamera = std::abs(chunkX - cameraChunkX) <= radius && std::abs(chunkY - cameraChunkY) <= radius;
+    bool nearPrediction = std::abs(chunkX - predictedChunkX) <= radius && std::abs(chunkY - predictedChunkY) <= radius;
+    return nearCamera || nearPrediction;
+}
+
+bool ChunkStreamer::HasStoredTiles(int chunkIndex) const {
+    int chunkCols = level.GetChunkCols();
+    return spillSlots[chunkIndex] != NO_SPILL_SLOT
+        || level.GetChunkEncoding(chunkIndex % chunkCols, chunkIndex / chunkCols) != CHUNK_EMPTY;
+}
+
+bool ChunkStreamer::SpillChunk(int chunkIndex) {
+    int chunkX = chunkIndex % level.GetChunkCols();
+    int chunkY = chunkIndex / level.GetChunkCols();
+    TileID tiles[TILE_CHUNK_SIZE * TILE_CHUNK_SIZE];
+    for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+        tileMap->CopyRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                             &tiles[row * TILE_CHUNK_SIZE], TILE_CHUNK_SIZE);
+    }
+    // a chunk spilled again overwrites its own slot, so the file never outgrows the edited chunks
+    Uint32 slot = spillSlots[chunkIndex] != NO_SPILL_SLOT ? spillSlots[chunkIndex] : spillCount;
+    std::lock_guard<std::mutex> lock(spillMutex);
+    if (spillFile == nullptr) spillFile = std::fopen(spillPath.c_str(), "w+b");
+    if (slot >= (Uint32)(LONG_MAX / SPILL_SLOT_BYTES)) return false;
+    if (spillFile == nullptr || std::fseek(spillFile, (long)(slot * SPILL_SLOT_BYTES), SEEK_SET) != 0
+        || std::fwrite(tiles, SPILL_SLOT_BYTES, 1, spillFile) != 1 || std::fflush(spillFile) != 0) {
+        SDL_Log("Chunk %d could not be written to %s, it stays in memory", chunkIndex, spillPath.c_str());
+        return false;
+    }
+    if (slot == spillCount) spillCount++;
+    spillSlots[chunkIndex] = slot;
+    return true;
+}
+
+bool ChunkStreamer::ReadSpilledChunk(Uint32 slot, TileID *out) {
+    std::lock_guard<std::mutex> lock(spillMutex);
+    return spillFile != nullptr && std::fseek(spillFile, (long)(slot * SPILL_SLOT_BYTES), SEEK_SET) == 0
+        && std::fread(out, SPILL_SLOT_BYTES, 1, spillFile) == 1;
+}
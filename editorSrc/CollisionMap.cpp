@@ -0,0 +1,330 @@
+/**
+ * @file CollisionMap.cpp
+ * @brief This file contains the collision queries against the solid tiles of a level.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include "CollisionMap.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// a chunk row is one word
+static_assert(TILE_CHUNK_SIZE <= 64, "a chunk row of the collision mask must fit in a word");
+
+// chunkMasks entry of a chunk without a solid tile
+const int MASK_CLEAR {-1};
+// chunkMasks entry of a chunk that is absent from the map, all of it solid
+const int MASK_ABSENT {-2};
+
+// bits lo..hi of a word, both inclusive
+Uint64 BitRange(int lo, int hi) {
+    return (~(Uint64)0 >> (63 - hi)) & (~(Uint64)0 << lo);
+}
+
+// index of the lowest set bit, word must not be 0
+int LowestBit(Uint64 word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// index of the highest set bit, word must not be 0
+int HighestBit(Uint64 word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+}
+
+CollisionMap::CollisionMap():width(0),height(0),chunkCols(0),chunkRows(0) {
+}
+
+CollisionMap::~CollisionMap() {
+}
+
+void CollisionMap::SetSolid(TileID id, bool solid) {
+    if (id < 0) return;
+    if (id >= (int)solidIds.size()) solidIds.resize(id + 1, true);
+    solidIds[id] = solid;
+}
+
+bool CollisionMap::IsSolidId(TileID id) const {
+    if (id < 0) return false;
+    return id >= (int)solidIds.size() || solidIds[id];
+}
+
+void CollisionMap::Build(const TileMap &map) {
+    width = map.GetWidth();
+    height = map.GetHeight();
+    chunkCols = map.GetChunkCols();
+    chunkRows = map.GetChunkRows();
+    chunkMasks.assign(chunkCols * chunkRows, MASK_CLEAR);
+    maskRows.clear();
+    freeMasks.clear();
+    builtVersions.assign(chunkCols * chunkRows, 0);
+    for (int chunkY = 0; chunkY < chunkRows; chunkY++) {
+        for (int chunkX = 0; chunkX < chunkCols; chunkX++) {
+            BuildChunk(map, chunkX, chunkY);
+        }
+    }
+}
+
+void CollisionMap::Update(TileMap &map) {
+    map.TakeChangedChunks(changedChunks);
+    if (map.GetWidth() != width || map.GetHeight() != height) {
+        Build(map);
+        return;
+    }
+    // only the reported chunks are looked at, however large the level is
+    for (int chunkIndex : changedChunks) {
+        int chunkX = chunkIndex % chunkCols, chunkY = chunkIndex / chunkCols;
+        bool absent = map.IsChunkAbsent(chunkX, chunkY);
+        if (builtVersions[chunkIndex] != map.GetChunkVersion(chunkX, chunkY)
+            || (chunkMasks[chunkIndex] == MASK_ABSENT) != absent) {
+            BuildChunk(map, chunkX, chunkY);
+        }
+    }
+}
+
+void CollisionMap::Apply(const TileMap &map, const TileChangeSet &changes) {
+    if (map.GetWidth() != width || map.GetHeight() != height) {
+        Build(map);
+        return;
+    }
+    for (int chunkIndex : changes.chunks) {
+        BuildChunk(map, chunkIndex % chunkCols, chunkIndex / chunkCols);
+    }
+}
+
+bool CollisionMap::IsSolidTile(int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) return false;
+    return (GetChunkRowBits(x / TILE_CHUNK_SIZE, y) >> (x % TILE_CHUNK_SIZE)) & 1;
+}
+
+bool CollisionMap::IsSolidPoint(int px, int py) const {
+    return IsSolidTile(FloorDiv(px, TILE_SIZE), FloorDiv(py, TILE_SIZE));
+}
+
+bool CollisionMap::IsAreaSolid(const SDL_Rect &area) const {
+    if (area.w <= 0 || area.h <= 0) return false;
+    int firstX = FloorDiv(area.x, TILE_SIZE), lastX = FloorDiv(area.x + area.w - 1, TILE_SIZE);
+    int firstY = std::max(0, FloorDiv(area.y, TILE_SIZE));
+    int lastY = std::min(height - 1, FloorDiv(area.y + area.h - 1, TILE_SIZE));
+    for (int y = firstY; y <= lastY; y++) {
+        if (IsRowSpanSolid(y, firstX, lastX)) return true;
+    }
+    return false;
+}
+
+int CollisionMap::GetContacts(const SDL_Rect &box) const {
+    int contacts = CONTACT_NONE;
+    // one pixel wide strips just outside each side of the box
+    if (IsAreaSolid({box.x, box.y + box.h, box.w, 1})) contacts |= CONTACT_GROUND;
+    if (IsAreaSolid({box.x, box.y - 1, box.w, 1})) contacts |= CONTACT_CEILING;
+    if (IsAreaSolid({box.x - 1, box.y, 1, box.h})) contacts |= CONTACT_LEFT;
+    if (IsAreaSolid({box.x + box.w, box.y, 1, box.h})) contacts |= CONTACT_RIGHT;
+    return contacts;
+}
+
+SweepResult CollisionMap::Sweep(const SDL_Rect &box, int dx, int dy) const {
+    SweepResult result = {dx, dy, false, false};
+    if (box.w <= 0 || box.h <= 0) return result;
+
+    // horizontally, only the columns the leading edge enters can stop the box
+    int firstRow = std::max(0, FloorDiv(box.y, TILE_SIZE));
+    int lastRow = std::min(height - 1, FloorDiv(box.y + box.h - 1, TILE_SIZE));
+    if (dx > 0) {
+        int fromCol = FloorDiv(box.x + box.w - 1, TILE_SIZE) + 1;
+        int toCol = FloorDiv(box.x + box.w - 1 + dx, TILE_SIZE);
+        int nearest = std::numeric_limits<int>::max();
+        for (int y = firstRow; y <= lastRow; y++) {
+            // later rows only matter if they stop the box sooner
+            int limit = std::min(toCol, nearest - 1);
+            if (limit < fromCol) break;
+            int col = FindSolidInRow(y, fromCol, limit);
+            if (col >= 0) nearest = col;
+        }
+        if (nearest != std::numeric_limits<int>::max()) {
+            result.dx = nearest * TILE_SIZE - (box.x + box.w);
+            result.hitX = true;
+        }
+    } else if (dx < 0) {
+        int fromCol = FloorDiv(box.x, TILE_SIZE) - 1;
+        int toCol = FloorDiv(box.x + dx, TILE_SIZE);
+        int nearest = std::numeric_limits<int>::min();
+        for (int y = firstRow; y <= lastRow; y++) {
+            int limit = std::max(toCol, nearest + 1);
+            if (limit > fromCol) break;
+            int col = FindSolidInRow(y, fromCol, limit);
+            if (col >= 0) nearest = col;
+        }
+        if (nearest != std::numeric_limits<int>::min()) {
+            result.dx = (nearest + 1) * TILE_SIZE - box.x;
+            result.hitX = true;
+        }
+    }
+
+    // vertically from where the horizontal move ended, a whole row of columns per test
+    int x = box.x + result.dx;
+    int firstCol = FloorDiv(x, TILE_SIZE), lastCol = FloorDiv(x + box.w - 1, TILE_SIZE);
+    if (dy > 0) {
+        int fromRow = std::max(0, FloorDiv(box.y + box.h - 1, TILE_SIZE) + 1);
+        int toRow = std::min(height - 1, FloorDiv(box.y + box.h - 1 + dy, TILE_SIZE));
+        for (int y = fromRow; y <= toRow; y++) {
+            if (IsRowSpanSolid(y, firstCol, lastCol)) {
+                result.dy = y * TILE_SIZE - (box.y + box.h);
+                result.hitY = true;
+                break;
+            }
+        }
+    } else if (dy < 0) {
+        int fromRow = std::min(height - 1, FloorDiv(box.y, TILE_SIZE) - 1);
+        int toRow = std::max(0, FloorDiv(box.y + dy, TILE_SIZE));
+        for (int y = fromRow; y >= toRow; y--) {
+            if (IsRowSpanSolid(y, firstCol, lastCol)) {
+                result.dy = (y + 1) * TILE_SIZE - box.y;
+                result.hitY = true;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool CollisionMap::Raycast(int x0, int y0, int x1, int y1, int &hitX, int &hitY) const {
+    int tileX = FloorDiv(x0, TILE_SIZE), tileY = FloorDiv(y0, TILE_SIZE);
+    int endX = FloorDiv(x1, TILE_SIZE), endY = FloorDiv(y1, TILE_SIZE);
+
+    // a segment inside one row is scanned a word at a time
+    if (tileY == endY) {
+        int col = FindSolidInRow(tileY, tileX, endX);
+        if (col < 0) return false;
+        hitX = col;
+        hitY = tileY;
+        return true;
+    }
+
+    // otherwise step from tile to tile in the order the segment crosses them
+    int stepX = x1 > x0 ? 1 : -1, stepY = y1 > y0 ? 1 : -1;
+    double lengthX = std::abs(x1 - x0), lengthY = std::abs(y1 - y0);
+    double infinity = std::numeric_limits<double>::infinity();
+    double deltaX = lengthX > 0 ? TILE_SIZE / lengthX : infinity;
+    double deltaY = TILE_SIZE / lengthY;
+    double nextX = lengthX > 0 ? (stepX > 0 ? (tileX + 1) * TILE_SIZE - x0 : x0 - tileX * TILE_SIZE) / lengthX : infinity;
+    double nextY = (stepY > 0 ? (tileY + 1) * TILE_SIZE - y0 : y0 - tileY * TILE_SIZE) / lengthY;
+    int steps = std::abs(endX - tileX) + std::abs(endY - tileY);
+    for (int i = 0; ; i++) {
+        if (IsSolidTile(tileX, tileY)) {
+            hitX = tileX;
+            hitY = tileY;
+            return true;
+        }
+        if (i == steps) return false;
+        if (nextX < nextY) {
+            nextX += deltaX;
+            tileX += stepX;
+        } else {
+            nextY += deltaY;
+            tileY += stepY;
+        }
+    }
+}
+
+void CollisionMap::BuildChunk(const TileMap &map, int chunkX, int chunkY) {
+    int chunkIndex = chunkY * chunkCols + chunkX;
+    builtVersions[chunkIndex] = map.GetChunkVersion(chunkX, chunkY);
+    int &mask = chunkMasks[chunkIndex];
+    Uint64 rows[TILE_CHUNK_SIZE] = {};
+    bool solid = false;
+    if (!map.IsChunkAbsent(chunkX, chunkY)) {
+        int firstX = chunkX * TILE_CHUNK_SIZE;
+        int count = std::min(width - firstX, TILE_CHUNK_SIZE);
+        int rowCount = std::min(height - chunkY * TILE_CHUNK_SIZE, TILE_CHUNK_SIZE);
+        for (int row = 0; row < rowCount; row++) {
+            map.ForEachTileRun(firstX, chunkY * TILE_CHUNK_SIZE + row, count, [&](int runX, int length, TileID id) {
+                if (!IsSolidId(id)) return;
+                rows[row] |= BitRange(runX - firstX, runX - firstX + length - 1);
+                solid = true;
+            });
+        }
+    }
+    if (!solid) {
+        // chunks without a solid tile give their mask back
+        if (mask >= 0) freeMasks.push_back(mask);
+        mask = map.IsChunkAbsent(chunkX, chunkY) ? MASK_ABSENT : MASK_CLEAR;
+        return;
+    }
+    if (mask < 0) {
+        if (freeMasks.empty()) {
+            mask = (int)maskRows.size();
+            maskRows.resize(maskRows.size() + TILE_CHUNK_SIZE);
+        } else {
+            mask = freeMasks.back();
+            freeMasks.pop_back();
+        }
+    }
+    std::copy(rows, rows + TILE_CHUNK_SIZE, &maskRows[mask]);
+}
+
+Uint64 CollisionMap::GetChunkRowBits(int chunkX, int y) const {
+    int mask = chunkMasks[(y / TILE_CHUNK_SIZE) * chunkCols + chunkX];
+    if (mask == MASK_CLEAR) return 0;
+    if (mask == MASK_ABSENT) return BitRange(0, TILE_CHUNK_SIZE - 1);
+    return maskRows[mask + y % TILE_CHUNK_SIZE];
+}
+
+bool CollisionMap::IsRowSpanSolid(int y, int firstX, int lastX) const {
+    if (y < 0 || y >= height) return false;
+    firstX = std::max(0, firstX);
+    lastX = std::min(width - 1, lastX);
+    if (firstX > lastX) return false;
+    int firstChunk = firstX / TILE_CHUNK_SIZE, lastChunk = lastX / TILE_CHUNK_SIZE;
+    for (int chunkX = firstChunk; chunkX <= lastChunk; chunkX++) {
+        Uint64 span = BitRange(chunkX == firstChunk ? firstX % TILE_CHUNK_SIZE : 0,
+                               chunkX == lastChunk ? lastX % TILE_CHUNK_SIZE : TILE_CHUNK_SIZE - 1);
+        if (GetChunkRowBits(chunkX, y) & span) return true;
+    }
+    return false;
+}
+
+int CollisionMap::FindSolidInRow(int y, int firstX, int lastX) const {
+    if (y < 0 || y >= height) return -1;
+    if (firstX <= lastX) {
+        firstX = std::max(0, firstX);
+        lastX = std::min(width - 1, lastX);
+        if (firstX > lastX) return -1;
+        int firstChunk = firstX / TILE_CHUNK_SIZE, lastChunk = lastX / TILE_CHUNK_SIZE;
+        for (int chunkX = firstChunk; chunkX <= lastChunk; chunkX++) {
+            Uint64 hits = GetChunkRowBits(chunkX, y)
+                & BitRange(chunkX == firstChunk ? firstX % TILE_CHUNK_SIZE : 0,
+                           chunkX == lastChunk ? lastX % TILE_CHUNK_SIZE : TILE_CHUNK_SIZE - 1);
+            if (hits) return chunkX * TILE_CHUNK_SIZE + LowestBit(hits);
+        }
+    } else {
+        firstX = std::min(width - 1, firstX);
+        lastX = std::max(0, lastX);
+        if (firstX < lastX) return -1;
+        int firstChunk = firstX / TILE_CHUNK_SIZE, lastChunk = lastX / TILE_CHUNK_SIZE;
+        for (int chunkX = firstChunk; chunkX >= lastChunk; chunkX--) {
+            Uint64 hits = GetChunkRowBits(chunkX, y)
+                & BitRange(chunkX == lastChunk ? lastX % TILE_CHUNK_SIZE : 0,
+                           chunkX == firstChunk ? firstX % TILE_CHUNK_SIZE : TILE_CHUNK_SIZE - 1);
+            if (hits) return chunkX * TILE_CHUNK_SIZE + HighestBit(hits);
+        }
+    }
+    return -1;
+}
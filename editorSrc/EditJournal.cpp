@@ -0,0 +1,155 @@
+/**
+ * @file EditJournal.cpp
+ * @brief This file contains the undo and redo history of the tile edits made to a level.
+ */
+#include <algorithm>
+#include "EditJournal.hpp"
+
+namespace {
+
+// how much memory the history spends on a vector
+template<typename T>
+size_t VectorBytes(const std::vector<T> &values) {
+    return values.capacity() * sizeof(T);
+}
+
+}
+
+EditJournal::EditJournal(size_t maxBytes):maxBytes(maxBytes),usedBytes(0),width(0),recording(false) {
+}
+
+EditJournal::~EditJournal() {
+}
+
+void EditJournal::BeginTransaction() {
+    recording = true;
+}
+
+void EditJournal::EndTransaction() {
+    if (!recording) return;
+    recording = false;
+    if (pending.empty()) return;
+
+    // order the writes by cell, a stable sort keeps the writes to one cell in the order they were made
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const CellChange &a, const CellChange &b) { return a.cell < b.cell; });
+
+    Entry entry;
+    auto appendRun = [](std::vector<IdRun> &runs, Uint32 firstRun, TileID id) {
+        if (runs.size() > firstRun && runs.back().id == id && runs.back().length < 0xFFFF) runs.back().length++;
+        else runs.push_back({id, 1});
+    };
+    for (size_t i = 0; i < pending.size(); ) {
+        // the first old id and the last new id of a cell are all that matter
+        size_t last = i;
+        while (last + 1 < pending.size() && pending[last + 1].cell == pending[i].cell) last++;
+        Uint32 cell = pending[i].cell;
+        TileID oldId = pending[i].oldId, newId = pending[last].newId;
+        i = last + 1;
+        if (oldId == newId) continue;
+
+        // spans never wrap into the next row, so each can be written with one row span
+        bool extends = !entry.spans.empty();
+        if (extends) {
+            const Span &span = entry.spans.back();
+            extends = span.firstCell + span.count == cell && cell % width != 0;
+        }
+        if (!extends) {
+            entry.spans.push_back({cell, 0, (Uint32)entry.oldRuns.size(), (Uint32)entry.newRuns.size()});
+        }
+        Span &span = entry.spans.back();
+        span.count++;
+        appendRun(entry.oldRuns, span.firstOldRun, oldId);
+        appendRun(entry.newRuns, span.firstNewRun, newId);
+    }
+    pending.clear();
+    if (entry.spans.empty()) return;
+
+    entry.spans.shrink_to_fit();
+    entry.oldRuns.shrink_to_fit();
+    entry.newRuns.shrink_to_fit();
+    entry.bytes = VectorBytes(entry.spans) + VectorBytes(entry.oldRuns) + VectorBytes(entry.newRuns);
+    ClearRedo();
+    usedBytes += entry.bytes;
+    undoEntries.push_back(std::move(entry));
+    Trim();
+}
+
+void EditJournal::Record(int mapWidth, int x, int y, const TileID *oldIds, const TileID *newIds, int count) {
+    if (!recording) return;
+    width = mapWidth;
+    Uint32 firstCell = (Uint32)y * mapWidth + x;
+    for (int i = 0; i < count; i++) {
+        if (oldIds[i] != newIds[i]) pending.push_back({firstCell + i, oldIds[i], newIds[i]});
+    }
+}
+
+bool EditJournal::Undo(TileMap &map) {
+    // a stroke still being drawn is split here, its rest goes into a new transaction
+    bool wasRecording = recording;
+    EndTransaction();
+    if (undoEntries.empty()) {
+        recording = wasRecording;
+        return false;
+    }
+    Apply(map, undoEntries.back(), false);
+    redoEntries.push_back(std::move(undoEntries.back()));
+    undoEntries.pop_back();
+    recording = wasRecording;
+    return true;
+}
+
+bool EditJournal::Redo(TileMap &map) {
+    // a stroke still being drawn is split here, its rest goes into a new transaction
+    bool wasRecording = recording;
+    EndTransaction();
+    if (redoEntries.empty()) {
+        recording = wasRecording;
+        return false;
+    }
+    Apply(map, redoEntries.back(), true);
+    undoEntries.push_back(std::move(redoEntries.back()));
+    redoEntries.pop_back();
+    recording = wasRecording;
+    return true;
+}
+
+void EditJournal::Clear() {
+    recording = false;
+    pending.clear();
+    undoEntries.clear();
+    redoEntries.clear();
+    usedBytes = 0;
+}
+
+void EditJournal::Apply(TileMap &map, const Entry &entry, bool useNew) {
+    if (map.GetWidth() != width) {
+        SDL_Log("Edit history of a %d wide map does not fit a %d wide map", width, map.GetWidth());
+        return;
+    }
+    const std::vector<IdRun> &runs = useNew ? entry.newRuns : entry.oldRuns;
+    for (size_t i = 0; i < entry.spans.size(); i++) {
+        const Span &span = entry.spans[i];
+        Uint32 firstRun = useNew ? span.firstNewRun : span.firstOldRun;
+        Uint32 endRun = (Uint32)runs.size();
+        if (i + 1 < entry.spans.size()) endRun = useNew ? entry.spans[i + 1].firstNewRun : entry.spans[i + 1].firstOldRun;
+        spanIds.clear();
+        for (Uint32 run = firstRun; run < endRun; run++) {
+            spanIds.insert(spanIds.end(), runs[run].length, runs[run].id);
+        }
+        map.SetRowSpan(span.firstCell % width, span.firstCell / width, spanIds.data(), span.count);
+    }
+}
+
+void EditJournal::Trim() {
+    // the newest transaction is kept even when it alone is over the limit
+    while (usedBytes > maxBytes && undoEntries.size() > 1) {
+        usedBytes -= undoEntries.front().bytes;
+        undoEntries.pop_front();
+    }
+}
+
+void EditJournal::ClearRedo() {
+    for (const Entry &entry : redoEntries) usedBytes -= entry.bytes;
+    redoEntries.clear();
+}
@@ -0,0 +1,55 @@
+/**
+ * @file InputLatency.cpp
+ * @brief This file contains the histogram of the delay between input and the frame that shows it.
+ */
+#include "InputLatency.hpp"
+
+InputLatency::InputLatency():count(0) {
+    buckets.fill(0);
+    // a frame rarely handles more events than this, so remembering them does not allocate
+    pending.reserve(64);
+}
+
+InputLatency::~InputLatency() {
+}
+
+void InputLatency::OnEvent(Uint32 timestamp) {
+    pending.push_back(timestamp);
+}
+
+void InputLatency::OnPresent(Uint32 now) {
+    for (Uint32 timestamp : pending) {
+        // the difference of unsigned ticks stays right when the counter wraps around
+        Uint32 latency = now - timestamp;
+        buckets[latency < (Uint32)INPUT_LATENCY_MAX_MS ? latency : INPUT_LATENCY_MAX_MS]++;
+        count++;
+    }
+    pending.clear();
+}
+
+int InputLatency::GetPercentile(double fraction) const {
+    if (count == 0) return 0;
+    Uint64 target = (Uint64)(fraction * count + 0.5);
+    if (target < 1) target = 1;
+    Uint64 seen = 0;
+    for (int ms = 0; ms <= INPUT_LATENCY_MAX_MS; ms++) {
+        seen += buckets[ms];
+        if (seen >= target) return ms;
+    }
+    return INPUT_LATENCY_MAX_MS;
+}
+
+void InputLatency::Reset() {
+    buckets.fill(0);
+    count = 0;
+    pending.clear();
+}
+
+void InputLatency::Report(std::ostream &out) const {
+    out << "Input to present latency of " << count << " events: p50 " << GetPercentile(0.5)
+        << "ms, p90 " << GetPercentile(0.9) << "ms, p99 " << GetPercentile(0.99) << "ms\n";
+    for (int ms = 0; ms <= INPUT_LATENCY_MAX_MS; ms++) {
+        if (buckets[ms] == 0) continue;
+        out << (ms == INPUT_LATENCY_MAX_MS ? ">=" : "  ") << ms << "ms " << buckets[ms] << "\n";
+    }
+}
@@ -0,0 +1,235 @@
+/**
+ * @file InputLog.cpp
+ * @brief This file contains the recording and replay of the input of an editor session.
+ */
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "InputLog.hpp"
+
+namespace {
+
+void WriteVarint(std::vector<Uint8> &out, Uint32 value) {
+    while (value >= 0x80) {
+        out.push_back((Uint8)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((Uint8)value);
+}
+
+// signed values are interleaved so that small negative numbers stay short
+void WriteSigned(std::vector<Uint8> &out, Sint32 value) {
+    WriteVarint(out, ((Uint32)value << 1) ^ (Uint32)(value >> 31));
+}
+
+bool ReadVarint(const std::vector<Uint8> &data, size_t &position, Uint32 &value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (position >= data.size()) return false;
+        Uint8 byte = data[position++];
+        value |= (Uint32)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool ReadSigned(const std::vector<Uint8> &data, size_t &position, Sint32 &value) {
+    Uint32 zigzag;
+    if (!ReadVarint(data, position, zigzag)) return false;
+    value = (Sint32)(zigzag >> 1) ^ -(Sint32)(zigzag & 1);
+    return true;
+}
+
+// decode the record at position into an event, or the checksum for INPUT_END
+bool ReadRecord(const std::vector<Uint8> &data, size_t &position, Uint32 &tickDelta, Uint8 &type,
+                SDL_Event &event, Uint32 &checksum) {
+    if (!ReadVarint(data, position, tickDelta) || position >= data.size()) return false;
+    type = data[position++];
+    SDL_zero(event);
+    Uint32 value, modifiers;
+    Sint32 x, y;
+    switch (type) {
+        case INPUT_KEY_DOWN:
+            if (!ReadVarint(data, position, value) || !ReadVarint(data, position, modifiers)) return false;
+            event.type = SDL_KEYDOWN;
+            event.key.state = SDL_PRESSED;
+            event.key.keysym.sym = (SDL_Keycode)value;
+            event.key.keysym.mod = (Uint16)modifiers;
+            return true;
+        case INPUT_MOUSE_DOWN:
+        case INPUT_MOUSE_UP:
+            if (position >= data.size()) return false;
+            value = data[position++];
+            if (!ReadSigned(data, position, x) || !ReadSigned(data, position, y)) return false;
+            event.type = type == INPUT_MOUSE_DOWN ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+            event.button.state = type == INPUT_MOUSE_DOWN ? SDL_PRESSED : SDL_RELEASED;
+            event.button.button = (Uint8)value;
+            event.button.x = x;
+            event.button.y = y;
+            return true;
+        case INPUT_MOUSE_MOTION:
+            if (!ReadVarint(data, position, value) || !ReadSigned(data, position, x) || !ReadSigned(data, position, y)) return false;
+            event.type = SDL_MOUSEMOTION;
+            event.motion.state = value;
+            event.motion.x = x;
+            event.motion.y = y;
+            return true;
+        case INPUT_END:
+            if (position + sizeof(Uint32) > data.size()) return false;
+            memcpy(&checksum, &data[position], sizeof(Uint32));
+            checksum = SDL_SwapLE32(checksum);
+            position += sizeof(Uint32);
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+InputRecorder::InputRecorder():file(nullptr),lastTick(0) {
+}
+
+InputRecorder::~InputRecorder() {
+    if (file != nullptr) fclose(file);
+}
+
+bool InputRecorder::Open(const std::string &logPath) {
+    if (file != nullptr) fclose(file);
+    lastTick = 0;
+    file = fopen(logPath.c_str(), "wb");
+    if (nullptr == file) {
+        SDL_Log("Failed to create input log %s", logPath.c_str());
+        return false;
+    }
+    InputLogHeader header;
+    memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+    header.version = SDL_SwapLE32(INPUT_LOG_VERSION);
+    header.updatesPerSecond = SDL_SwapLE32((Uint32)UPDATES_PER_SECOND);
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        SDL_Log("Failed to write input log %s", logPath.c_str());
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool InputRecorder::IsRecorded(const SDL_Event &event) {
+    return event.type == SDL_KEYDOWN || event.type == SDL_MOUSEBUTTONDOWN
+        || event.type == SDL_MOUSEBUTTONUP || event.type == SDL_MOUSEMOTION;
+}
+
+void InputRecorder::Record(Uint32 tick, const SDL_Event &event) {
+    if (file == nullptr || !IsRecorded(event)) return;
+    switch (event.type) {
+        case SDL_KEYDOWN:
+            BeginRecord(tick, INPUT_KEY_DOWN);
+            WriteVarint(record, (Uint32)event.key.keysym.sym);
+            WriteVarint(record, event.key.keysym.mod);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            BeginRecord(tick, event.type == SDL_MOUSEBUTTONDOWN ? INPUT_MOUSE_DOWN : INPUT_MOUSE_UP);
+            record.push_back(event.button.button);
+            WriteSigned(record, event.button.x);
+            WriteSigned(record, event.button.y);
+            break;
+        case SDL_MOUSEMOTION:
+            BeginRecord(tick, INPUT_MOUSE_MOTION);
+            WriteVarint(record, event.motion.state);
+            WriteSigned(record, event.motion.x);
+            WriteSigned(record, event.motion.y);
+            break;
+    }
+    // stdio buffers the small records into large writes
+    fwrite(record.data(), 1, record.size(), file);
+}
+
+bool InputRecorder::Close(Uint32 tick, Uint32 levelChecksum) {
+    if (file == nullptr) return false;
+    BeginRecord(tick, INPUT_END);
+    Uint32 checksum = SDL_SwapLE32(levelChecksum);
+    const Uint8 *bytes = reinterpret_cast<const Uint8*>(&checksum);
+    record.insert(record.end(), bytes, bytes + sizeof(checksum));
+    bool written = fwrite(record.data(), 1, record.size(), file) == record.size();
+    written = fclose(file) == 0 && written;
+    file = nullptr;
+    return written;
+}
+
+void InputRecorder::BeginRecord(Uint32 tick, INPUT_RECORD_TYPE type) {
+    record.clear();
+    WriteVarint(record, tick - lastTick);
+    record.push_back((Uint8)type);
+    lastTick = tick;
+}
+
+InputReplayer::InputReplayer():position(0),validEnd(0),lastTick(0),open(false),updatesPerSecond(0),
+                               hasEnd(false),endTick(0),levelChecksum(0) {
+}
+
+InputReplayer::~InputReplayer() {
+}
+
+bool InputReplayer::Open(const std::string &logPath) {
+    open = false;
+    std::ifstream file(logPath, std::ios::binary);
+    if (!file.is_open()) {
+        SDL_Log("Failed to open input log %s", logPath.c_str());
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    InputLogHeader header;
+    if (data.size() < sizeof(header)) {
+        SDL_Log("Input log %s is too short", logPath.c_str());
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) != 0
+        || SDL_SwapLE32(header.version) != INPUT_LOG_VERSION) {
+        SDL_Log("%s is not an input log of version %u", logPath.c_str(), INPUT_LOG_VERSION);
+        return false;
+    }
+    updatesPerSecond = SDL_SwapLE32(header.updatesPerSecond);
+
+    // find the end of the session, or of the readable records if the recording was cut short
+    hasEnd = false;
+    validEnd = sizeof(header);
+    Uint32 tick = 0, tickDelta, checksum = 0;
+    Uint8 type;
+    SDL_Event event;
+    for (size_t scan = validEnd; ReadRecord(data, scan, tickDelta, type, event, checksum); ) {
+        tick += tickDelta;
+        validEnd = scan;
+        if (type == INPUT_END) {
+            hasEnd = true;
+            endTick = tick;
+            levelChecksum = checksum;
+            break;
+        }
+    }
+    if (!hasEnd) SDL_Log("Input log %s has no end, replaying the events up to where it breaks off", logPath.c_str());
+    position = sizeof(header);
+    lastTick = 0;
+    open = true;
+    return true;
+}
+
+bool InputReplayer::Next(Uint32 tick, SDL_Event &event) {
+    if (!open || position >= validEnd) return false;
+    size_t next = position;
+    Uint32 tickDelta, checksum;
+    Uint8 type;
+    if (!ReadRecord(data, next, tickDelta, type, event, checksum)) return false;
+    if (type == INPUT_END || lastTick + tickDelta > tick) return false;
+    position = next;
+    lastTick += tickDelta;
+    event.common.timestamp = SDL_GetTicks();
+    return true;
+}
+
+bool InputReplayer::IsFinished(Uint32 tick) const {
+    if (!open) return true;
+    return hasEnd ? tick >= endTick : position >= validEnd;
+}
@@ -0,0 +1,279 @@
+/**
+ * @file LevelFile.cpp
+ * @brief This file contains the binary level format and its memory mapped reader.
+ */
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "LevelFile.hpp"
+
+// every chunk payload starts on this boundary so raw tiles can be read in place
+const size_t CHUNK_ALIGNMENT {8};
+
+LevelFile::LevelFile():header(nullptr),chunkTable(nullptr),chunkCols(0),chunkRows(0) {
+}
+
+LevelFile::~LevelFile() {
+    Close();
+}
+
+bool LevelFile::Open(const std::string &filePath) {
+    Close();
+    if (!file.Open(filePath)) {
+        SDL_Log("Failed to map level file %s", filePath.c_str());
+        return false;
+    }
+    const char *data = file.Data();
+    size_t size = file.Size();
+    const LevelFileHeader *candidate = (const LevelFileHeader*)data;
+    if (size < sizeof(LevelFileHeader) || std::memcmp(candidate->magic, LEVEL_FILE_MAGIC, 4) != 0) {
+        SDL_Log("%s is not a binary level", filePath.c_str());
+        Close();
+        return false;
+    }
+    if (candidate->version > LEVEL_FILE_VERSION || candidate->chunkSize == 0) {
+        SDL_Log("%s uses unsupported level format version %d", filePath.c_str(), candidate->version);
+        Close();
+        return false;
+    }
+    // a corrupt header must not reach the int sizes of the reader or of TileMap
+    Uint64 chunkSize = candidate->chunkSize;
+    Uint64 mapChunks = ((Uint64)candidate->width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE
+        * (((Uint64)candidate->height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE);
+    if (chunkSize > LEVEL_MAX_CHUNK_SIZE || candidate->width > LEVEL_MAX_SIDE || candidate->height > LEVEL_MAX_SIDE
+        || mapChunks > LEVEL_MAX_MAP_CHUNKS) {
+        SDL_Log("%s declares a %ux%u level in chunks of %u, which is too large", filePath.c_str(),
+                candidate->width, candidate->height, candidate->chunkSize);
+        Close();
+        return false;
+    }
+    Uint64 cols = ((Uint64)candidate->width + chunkSize - 1) / chunkSize;
+    Uint64 rows = ((Uint64)candidate->height + chunkSize - 1) / chunkSize;
+    Uint64 tableBytes = (Uint64)candidate->chunkCount * sizeof(LevelChunkEntry);
+    if (cols * rows != candidate->chunkCount
+        || candidate->chunkTableOffset % alignof(LevelChunkEntry) != 0
+        || candidate->chunkTableOffset > size || tableBytes > size - candidate->chunkTableOffset) {
+        SDL_Log("%s has a broken chunk table", filePath.c_str());
+        Close();
+        return false;
+    }
+    Uint64 rawBytes = chunkSize * chunkSize * sizeof(TileID);
+    const LevelChunkEntry *table = (const LevelChunkEntry*)(data + candidate->chunkTableOffset);
+    for (Uint32 i = 0; i < candidate->chunkCount; i++) {
+        const LevelChunkEntry &entry = table[i];
+        if (entry.offset > size || entry.size > size - entry.offset || entry.encoding > CHUNK_RLE
+            || entry.offset % alignof(TileID) != 0
+            || (entry.encoding == CHUNK_RAW
+                && entry.size != rawBytes)) {
+            SDL_Log("%s has a broken chunk %d", filePath.c_str(), i);
+            Close();
+            return false;
+        }
+    }
+    header = candidate;
+    chunkTable = table;
+    chunkCols = (int)cols;
+    chunkRows = (int)rows;
+    return true;
+}
+
+void LevelFile::Close() {
+    file.Close();
+    header = nullptr;
+    chunkTable = nullptr;
+    chunkCols = 0;
+    chunkRows = 0;
+}
+
+int LevelFile::GetChunkEncoding(int chunkX, int chunkY) const {
+    const LevelChunkEntry *entry = GetEntry(chunkX, chunkY);
+    return entry ? (int)entry->encoding : (int)CHUNK_EMPTY;
+}
+
+const TileID *LevelFile::GetRawChunk(int chunkX, int chunkY) const {
+    const LevelChunkEntry *entry = GetEntry(chunkX, chunkY);
+    if (entry == nullptr || entry->encoding != CHUNK_RAW) return nullptr;
+    return (const TileID*)(file.Data() + entry->offset);
+}
+
+bool LevelFile::DecodeChunk(int chunkX, int chunkY, TileID *out) const {
+    const LevelChunkEntry *entry = GetEntry(chunkX, chunkY);
+    if (entry == nullptr) return false;
+    size_t tileCount = header->chunkSize * header->chunkSize;
+    switch (entry->encoding) {
+        case CHUNK_EMPTY:
+            std::fill(out, out + tileCount, EMPTY_TILE);
+            return true;
+        case CHUNK_RAW:
+            std::memcpy(out, file.Data() + entry->offset, tileCount * sizeof(TileID));
+            return true;
+        default:
+            break;
+    }
+    // RLE: (count, id) pairs that must add up to exactly one chunk
+    const Uint16 *runs = (const Uint16*)(file.Data() + entry->offset);
+    size_t runCount = entry->size / (2 * sizeof(Uint16));
+    size_t written = 0;
+    for (size_t i = 0; i < runCount; i++) {
+        Uint16 count = runs[i * 2];
+        TileID id = (TileID)runs[i * 2 + 1];
+        if (written + count > tileCount) return false;
+        std::fill(out + written, out + written + count, id);
+        written += count;
+    }
+    return written == tileCount;
+}
+
+TileID LevelFile::GetTile(int x, int y) const {
+    if (header == nullptr || x < 0 || y < 0 || x >= GetWidth() || y >= GetHeight()) return EMPTY_TILE;
+    int chunkSize = header->chunkSize;
+    const LevelChunkEntry *entry = GetEntry(x / chunkSize, y / chunkSize);
+    size_t index = (y % chunkSize) * chunkSize + x % chunkSize;
+    if (entry->encoding == CHUNK_RAW) {
+        return ((const TileID*)(file.Data() + entry->offset))[index];
+    }
+    if (entry->encoding == CHUNK_RLE) {
+        const Uint16 *runs = (const Uint16*)(file.Data() + entry->offset);
+        size_t runCount = entry->size / (2 * sizeof(Uint16));
+        size_t start = 0;
+        for (size_t i = 0; i < runCount; i++) {
+            start += runs[i * 2];
+            if (index < start) return (TileID)runs[i * 2 + 1];
+        }
+    }
+    return EMPTY_TILE;
+}
+
+bool LevelFile::CopyTo(TileMap &map) const {
+    if (header == nullptr) return false;
+    int chunkSize = header->chunkSize;
+    map.Resize(GetWidth(), GetHeight());
+    std::vector<TileID> decoded(chunkSize * chunkSize);
+    for (int chunkY = 0; chunkY < chunkRows; chunkY++) {
+        for (int chunkX = 0; chunkX < chunkCols; chunkX++) {
+            // a freshly resized map is already empty
+            if (GetChunkEncoding(chunkX, chunkY) == CHUNK_EMPTY) continue;
+            const TileID *tiles = GetRawChunk(chunkX, chunkY);
+            if (tiles == nullptr) {
+                if (!DecodeChunk(chunkX, chunkY, decoded.data())) return false;
+                tiles = decoded.data();
+            }
+            for (int row = 0; row < chunkSize; row++) {
+                map.LoadRowSpan(chunkX * chunkSize, chunkY * chunkSize + row, tiles + row * chunkSize, chunkSize);
+            }
+        }
+        map.Compact();
+    }
+    return true;
+}
+
+bool LevelFile::IsLevelFile(const std::string &filePath) {
+    std::ifstream input(filePath, std::ios::binary);
+    char magic[4];
+    if (!input.read(magic, 4)) return false;
+    return std::memcmp(magic, LEVEL_FILE_MAGIC, 4) == 0;
+}
+
+bool LevelFile::Write(const TileMap &map, const std::string &filePath, bool compress) {
+    return Write(map.GetWidth(), map.GetHeight(), [&map](int chunkX, int chunkY, TileID *out) {
+        for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+            map.CopyRowSpan(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE + row,
+                            out + row * TILE_CHUNK_SIZE, TILE_CHUNK_SIZE);
+        }
+        return true;
+    }, filePath, compress);
+}
+
+bool LevelFile::Write(int width, int height, const ChunkSource &readChunk, const std::string &filePath, bool compress) {
+    const int chunkSize = TILE_CHUNK_SIZE;
+    const int chunkCols = (width + chunkSize - 1) / chunkSize;
+    const int chunkRows = (height + chunkSize - 1) / chunkSize;
+    LevelFileHeader fileHeader = {};
+    std::memcpy(fileHeader.magic, LEVEL_FILE_MAGIC, 4);
+    fileHeader.version = LEVEL_FILE_VERSION;
+    fileHeader.chunkSize = chunkSize;
+    fileHeader.width = width;
+    fileHeader.height = height;
+    fileHeader.chunkCount = chunkCols * chunkRows;
+
+    std::ofstream output(filePath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        SDL_Log("Failed to open level file %s", filePath.c_str());
+        return false;
+    }
+    // the payloads go straight to the file, only the chunk table is kept until the end
+    output.write((const char*)&fileHeader, sizeof(fileHeader));
+    Uint64 offset = sizeof(LevelFileHeader);
+    const char padding[CHUNK_ALIGNMENT] = {};
+    auto align = [&]() {
+        size_t padBytes = (CHUNK_ALIGNMENT - offset % CHUNK_ALIGNMENT) % CHUNK_ALIGNMENT;
+        output.write(padding, padBytes);
+        offset += padBytes;
+    };
+
+    std::vector<LevelChunkEntry> table(fileHeader.chunkCount);
+    std::vector<TileID> tiles(chunkSize * chunkSize);
+    std::vector<Uint16> runs;
+    for (int chunkY = 0; chunkY < chunkRows; chunkY++) {
+        for (int chunkX = 0; chunkX < chunkCols; chunkX++) {
+            // the source pads past the map edge with empty tiles
+            if (!readChunk(chunkX, chunkY, tiles.data())) {
+                SDL_Log("Chunk %d,%d of %s could not be read", chunkX, chunkY, filePath.c_str());
+                return false;
+            }
+            bool empty = std::all_of(tiles.begin(), tiles.end(), [](TileID id) { return id == EMPTY_TILE; });
+            LevelChunkEntry &entry = table[chunkY * chunkCols + chunkX];
+            entry = {};
+            if (empty) continue;
+
+            const char *payload = (const char*)tiles.data();
+            size_t payloadSize = tiles.size() * sizeof(TileID);
+            entry.encoding = CHUNK_RAW;
+            if (compress) {
+                runs.clear();
+                for (size_t i = 0; i < tiles.size(); ) {
+                    size_t runEnd = i + 1;
+                    while (runEnd < tiles.size() && tiles[runEnd] == tiles[i] && runEnd - i < 0xFFFF) runEnd++;
+                    runs.push_back((Uint16)(runEnd - i));
+                    runs.push_back((Uint16)tiles[i]);
+                    i = runEnd;
+                }
+                if (runs.size() * sizeof(Uint16) < payloadSize) {
+                    payload = (const char*)runs.data();
+                    payloadSize = runs.size() * sizeof(Uint16);
+                    entry.encoding = CHUNK_RLE;
+                }
+            }
+            align();
+            entry.offset = offset;
+            entry.size = (Uint32)payloadSize;
+            output.write(payload, payloadSize);
+            offset += payloadSize;
+        }
+    }
+    align();
+    fileHeader.chunkTableOffset = offset;
+    output.write((const char*)table.data(), table.size() * sizeof(LevelChunkEntry));
+    // the header goes in last, now that the table offset is known
+    output.seekp(0);
+    output.write((const char*)&fileHeader, sizeof(fileHeader));
+    return output.good();
+}
+
+bool LevelFile::Convert(const std::string &inputPath, const std::string &outputPath, bool compress) {
+    TileMap map;
+    if (IsLevelFile(inputPath)) {
+        LevelFile input;
+        if (!input.Open(inputPath) || !input.CopyTo(map)) return false;
+        return map.SaveToFile(outputPath);
+    }
+    if (!map.LoadFromFile(inputPath)) return false;
+    return Write(map, outputPath, compress);
+}
+
+const LevelChunkEntry *LevelFile::GetEntry(int chunkX, int chunkY) const {
+    if (chunkTable == nullptr || chunkX < 0 || chunkY < 0 || chunkX >= chunkCols || chunkY >= chunkRows) {
+        return nullptr;
+    }
+    return &chunkTable[chunkY * chunkCols + chunkX];
+}
@@ -0,0 +1,192 @@
+/**
+ * @file LevelTextParser.cpp
+ * @brief This file contains the loader for text levels.
+ */
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include "LevelTextParser.hpp"
+#include "MappedFile.hpp"
+
+// inputs smaller than this are parsed on the calling thread, starting threads costs more
+const size_t PARALLEL_PARSE_MIN_BYTES {256 * 1024};
+// stop collecting errors after this many, a wrong file would otherwise report every line
+const size_t MAX_PARSE_ERRORS {64};
+
+namespace {
+
+// one non-blank line of the file
+struct LineRange {
+    const char *begin;
+    const char *end;
+    int line;
+};
+
+// everything one thread found in its slice of the file
+struct LineSlice {
+    std::vector<LineRange> lines;
+    // lines in the slice including blank ones, to number the lines of later slices
+    int lineCount = 0;
+};
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+// record the non-blank lines of [begin, end), which starts at a line start and ends after a newline
+void FindLines(const char *begin, const char *end, LineSlice &slice) {
+    const char *lineBegin = begin;
+    while (lineBegin < end) {
+        const char *lineEnd = (const char*)std::memchr(lineBegin, '\n', end - lineBegin);
+        if (lineEnd == nullptr) lineEnd = end;
+        const char *p = lineBegin;
+        while (p < lineEnd && IsSpace(*p)) p++;
+        if (p < lineEnd) slice.lines.push_back({lineBegin, lineEnd, slice.lineCount});
+        slice.lineCount++;
+        lineBegin = lineEnd + 1;
+    }
+}
+
+int CountTokens(const char *p, const char *end) {
+    int count = 0;
+    while (p < end) {
+        while (p < end && IsSpace(*p)) p++;
+        if (p == end) break;
+        count++;
+        while (p < end && !IsSpace(*p)) p++;
+    }
+    return count;
+}
+
+// parse one row into width tiles, the row is already filled with EMPTY_TILE
+void ParseRow(const LineRange &row, int width, TileID *out, std::vector<LevelParseError> &errors) {
+    const char *p = row.begin;
+    int column = 0;
+    while (p < row.end) {
+        while (p < row.end && IsSpace(*p)) p++;
+        if (p == row.end) break;
+        int value = 0;
+        std::from_chars_result result = std::from_chars(p, row.end, value);
+        const char *tokenEnd = result.ptr;
+        bool valid = result.ec == std::errc() && (tokenEnd == row.end || IsSpace(*tokenEnd));
+        if (!valid) {
+            tokenEnd = p;
+            while (tokenEnd < row.end && !IsSpace(*tokenEnd)) tokenEnd++;
+        }
+        if (!valid || value < EMPTY_TILE || value > std::numeric_limits<TileID>::max()) {
+            if (errors.size() < MAX_PARSE_ERRORS) {
+                errors.push_back({row.line, "column " + std::to_string(column + 1) + ": '"
+                                  + std::string(p, tokenEnd) + "' is not a tile id"});
+            }
+        } else if (column < width) {
+            out[column] = (TileID)value;
+        }
+        column++;
+        p = tokenEnd;
+    }
+}
+
+}
+
+LevelTextParser::LevelTextParser():threadCount(0) {
+}
+
+LevelTextParser::~LevelTextParser() {
+}
+
+void LevelTextParser::SetThreadCount(int threads) {
+    threadCount = std::max(0, threads);
+}
+
+bool LevelTextParser::ParseFile(const std::string &filePath, TileMap &map) {
+    errors.clear();
+    MappedFile file;
+    if (!file.Open(filePath)) {
+        SDL_Log("Failed to open level file %s", filePath.c_str());
+        errors.push_back({0, "cannot open " + filePath});
+        return false;
+    }
+    return Parse(file.Data(), file.Size(), map);
+}
+
+bool LevelTextParser::Parse(const char *data, size_t size, TileMap &map) {
+    errors.clear();
+    int threads = ThreadsFor(size);
+
+    // 1. cut the file into one slice per thread at line starts and find the rows of each slice
+    std::vector<const char*> bounds(threads + 1);
+    bounds[0] = data;
+    bounds[threads] = data + size;
+    for (int i = 1; i < threads; i++) {
+        const char *cut = std::max(bounds[i - 1], data + size / threads * i);
+        const char *newline = (const char*)std::memchr(cut, '\n', data + size - cut);
+        bounds[i] = newline ? newline + 1 : data + size;
+    }
+    std::vector<LineSlice> slices(threads);
+    {
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back(FindLines, bounds[i], bounds[i + 1], std::ref(slices[i]));
+        }
+        FindLines(bounds[0], bounds[1], slices[0]);
+        for (std::thread &worker : workers) worker.join();
+    }
+    std::vector<LineRange> rows;
+    int firstLine = 1;
+    for (LineSlice &slice : slices) {
+        for (LineRange &row : slice.lines) {
+            row.line += firstLine;
+            rows.push_back(row);
+        }
+        firstLine += slice.lineCount;
+    }
+
+    // 2. the widest row sets the width, every thread measures and then parses a contiguous block of rows
+    int height = (int)rows.size();
+    auto firstRow = [&](int thread) { return (int)((long long)height * thread / threads); };
+    std::vector<int> threadWidths(threads, 0);
+    auto measureRows = [&](int thread) {
+        for (int y = firstRow(thread); y < firstRow(thread + 1); y++) {
+            threadWidths[thread] = std::max(threadWidths[thread], CountTokens(rows[y].begin, rows[y].end));
+        }
+    };
+    {
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++) workers.emplace_back(measureRows, i);
+        measureRows(0);
+        for (std::thread &worker : workers) worker.join();
+    }
+    int width = *std::max_element(threadWidths.begin(), threadWidths.end());
+    std::vector<TileID> tiles((size_t)width * height, EMPTY_TILE);
+    std::vector<std::vector<LevelParseError>> threadErrors(threads);
+    auto parseRows = [&](int thread) {
+        for (int y = firstRow(thread); y < firstRow(thread + 1); y++) {
+            ParseRow(rows[y], width, &tiles[(size_t)y * width], threadErrors[thread]);
+        }
+    };
+    {
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++) workers.emplace_back(parseRows, i);
+        parseRows(0);
+        for (std::thread &worker : workers) worker.join();
+    }
+
+    // each thread's errors are already in line order and the threads cover increasing lines
+    for (std::vector<LevelParseError> &found : threadErrors) {
+        for (LevelParseError &error : found) {
+            if (errors.size() == MAX_PARSE_ERRORS) break;
+            errors.push_back(std::move(error));
+        }
+    }
+    map.Assign(width, height, std::move(tiles));
+    return errors.empty();
+}
+
+int LevelTextParser::ThreadsFor(size_t size) const {
+    if (size < PARALLEL_PARSE_MIN_BYTES) return 1;
+    int threads = threadCount;
+    if (threads == 0) threads = (int)std::thread::hardware_concurrency();
+    return std::max(1, threads);
+}
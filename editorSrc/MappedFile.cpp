@@ -0,0 +1,102 @@
+/**
+ * @file MappedFile.cpp
+ * @brief This file contains a read-only memory mapping of a whole file.
+ */
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile():open(false),data(nullptr),size(0),mappingHandle(nullptr) {
+}
+#else
+MappedFile::MappedFile():open(false),data(nullptr),size(0) {
+}
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &filePath) {
+    Close();
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+    // windows refuses to map an empty file
+    if (size > 0) {
+        mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle != nullptr) {
+            data = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        }
+    }
+    // the mapping keeps the file alive on its own
+    CloseHandle(file);
+    if (size > 0 && data == nullptr) {
+        Close();
+        return false;
+    }
+    open = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+    data = nullptr;
+    size = 0;
+    open = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &filePath) {
+    Close();
+    int file = ::open(filePath.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        ::close(file);
+        return false;
+    }
+    size = (size_t)info.st_size;
+    // mmap refuses a length of 0
+    if (size > 0) {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(file);
+            size = 0;
+            return false;
+        }
+        data = (const char*)mapping;
+    }
+    // the mapping keeps the file alive on its own
+    ::close(file);
+    open = true;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data != nullptr) munmap((void*)data, size);
+    data = nullptr;
+    size = 0;
+    open = false;
+}
+
+#endif
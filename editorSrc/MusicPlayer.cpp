@@ -0,0 +1,52 @@
+/**
+ * @file MusicPlayer.cpp
+ * @brief This file contains the player of the background music.
+ */
+#include "MusicPlayer.hpp"
+
+MusicPlayer::MusicPlayer():music(nullptr) {
+}
+
+MusicPlayer::~MusicPlayer() {
+}
+
+bool MusicPlayer::Play(const char *const musicPath, int loops) {
+    Stop();
+    // Mix_LoadMUS only opens the file and reads its header, unlike Mix_LoadWAV
+    // which would decode the whole song into memory before returning
+    music = Mix_LoadMUS(musicPath);
+    if (nullptr == music) {
+        SDL_Log("Failed to open music %s: %s", musicPath, Mix_GetError());
+        return false;
+    }
+    if (Mix_PlayMusic(music, loops) < 0) {
+        SDL_Log("Failed to play music %s: %s", musicPath, Mix_GetError());
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void MusicPlayer::SetVolume(double volume) {
+    if (volume < 0) volume = 0;
+    if (volume > 1) volume = 1;
+    Mix_VolumeMusic((int)(volume * MIX_MAX_VOLUME + 0.5));
+}
+
+void MusicPlayer::TogglePause() {
+    if (music == nullptr) return;
+    if (Mix_PausedMusic()) Mix_ResumeMusic();
+    else Mix_PauseMusic();
+}
+
+bool MusicPlayer::IsPlaying() const {
+    return music != nullptr && Mix_PlayingMusic();
+}
+
+void MusicPlayer::Stop() {
+    if (music == nullptr) return;
+    // halting waits for the audio thread to let go of the music before it is freed
+    Mix_HaltMusic();
+    Mix_FreeMusic(music);
+    music = nullptr;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file PerfOverlay.cpp
+ * @brief This file contains the overlay that shows live performance numbers in the window.
+ */
+#include <algorithm>
+#include <cstdio>
+#include "PerfOverlay.hpp"
+
+PerfOverlay::PerfOverlay():newestFrame(0),updateMs(0),renderMs(0),updateSteps(0),inputLatency(nullptr),visible(false) {
+    frameTimes.fill(0);
+    text[0] = '\0';
+}
+
+PerfOverlay::~PerfOverlay() {
+}
+
+void PerfOverlay::RecordFrame(double frameMs, double updateMs, double renderMs, int updateSteps) {
+    newestFrame = (newestFrame + 1) % PERF_GRAPH_FRAMES;
+    frameTimes[newestFrame] = (float)frameMs;
+    this->updateMs = updateMs;
+    this->renderMs = renderMs;
+    this->updateSteps = updateSteps;
+}
+
+void PerfOverlay::Render(SDL_Renderer *ren, TextRenderer &textRenderer, int x, int y) {
+    if (!visible) return;
+
+    // the newest frame is the rightmost bar, older frames scroll off to the left
+    int graphTop = y - PERF_GRAPH_HEIGHT;
+    int barCount = 0;
+    float slowest = 0;
+    for (int i = 0; i < PERF_GRAPH_FRAMES; i++) {
+        float ms = frameTimes[(newestFrame + 1 + i) % PERF_GRAPH_FRAMES];
+        slowest = std::max(slowest, ms);
+        int height = (int)(std::min(1.0, ms / PERF_GRAPH_MAX_MS) * PERF_GRAPH_HEIGHT + 0.5);
+        if (height > 0) bars[barCount++] = {x + i, y - height, 1, height};
+    }
+    int length = snprintf(text, sizeof(text), "frame %4.1fms max %4.1f\nupd %3.1fms x%d rnd %3.1f\ndraws %d tex %.1fMB",
+                          frameTimes[newestFrame], slowest, updateMs, updateSteps, renderMs,
+                          RenderStats::GetDrawCalls(), RenderStats::GetTextureBytes() / (1024.0 * 1024.0));
+    int lines = 3;
+    if (inputLatency != nullptr && length > 0 && length < (int)sizeof(text)) {
+        snprintf(text + length, sizeof(text) - length, "\ninput p50 %dms p99 %dms",
+                 inputLatency->GetPercentile(0.5), inputLatency->GetPercentile(0.99));
+        lines++;
+    }
+
+    int textHeight = lines * textRenderer.GetLineHeight();
+    SDL_Rect panel {x, graphTop - textHeight, PERF_GRAPH_FRAMES, PERF_GRAPH_HEIGHT + textHeight};
+    SDL_SetRenderDrawColor(ren, 0x00, 0x00, 0x00, 0xFF);
+    SDL_RenderFillRect(ren, &panel);
+    SDL_SetRenderDrawColor(ren, 0x40, 0xC0, 0x40, 0xFF);
+    SDL_RenderFillRects(ren, bars.data(), barCount);
+    // frames taller than this line missed the frame budget
+    SDL_Rect budget {x, y - (int)(PERF_FRAME_BUDGET_MS / PERF_GRAPH_MAX_MS * PERF_GRAPH_HEIGHT + 0.5), PERF_GRAPH_FRAMES, 1};
+    SDL_SetRenderDrawColor(ren, 0xE0, 0x40, 0x40, 0xFF);
+    SDL_RenderFillRect(ren, &budget);
+    RenderStats::CountDrawCalls(3);
+    textRenderer.DrawDynamicText(ren, text, x, panel.y, {0xFF, 0xFF, 0xFF, 0xFF});
+}
@@ -0,0 +1,31 @@
+/**
+ * @file ProcessMemory.cpp
+ * @brief This file contains the memory use of the editor process as the operating system sees it.
+ */
+#include "ProcessMemory.hpp"
+
+#if defined(MINGW)
+    // the psapi functions are exported by kernel32 from this version on
+    #define PSAPI_VERSION 2
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+size_t GetPeakMemoryBytes() {
+#if defined(MINGW)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(MAC)
+    // macOS reports the peak in bytes, Linux in kilobytes
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,36 @@
+/**
+ * @file RenderStats.cpp
+ * @brief This file contains the counters of draw calls and texture memory shown by the performance overlay.
+ */
+#include "RenderStats.hpp"
+
+int RenderStats::frameDrawCalls = 0;
+int RenderStats::lastDrawCalls = 0;
+size_t RenderStats::textureBytes = 0;
+
+void RenderStats::CountDrawCalls(int count) {
+    frameDrawCalls += count;
+}
+
+void RenderStats::AddTexture(SDL_Texture *texture) {
+    textureBytes += TextureBytes(texture);
+}
+
+void RenderStats::RemoveTexture(SDL_Texture *texture) {
+    size_t bytes = TextureBytes(texture);
+    textureBytes -= bytes < textureBytes ? bytes : textureBytes;
+}
+
+void RenderStats::EndFrame() {
+    lastDrawCalls = frameDrawCalls;
+    frameDrawCalls = 0;
+}
+
+size_t RenderStats::TextureBytes(SDL_Texture *texture) {
+    Uint32 format;
+    int w, h;
+    if (texture == nullptr || SDL_QueryTexture(texture, &format, nullptr, &w, &h) != 0) return 0;
+    // compressed and planar formats report no bytes per pixel, count them as 32 bit
+    int bytesPerPixel = SDL_ISPIXELFORMAT_FOURCC(format) ? 4 : SDL_BYTESPERPIXEL(format);
+    return (size_t)w * h * (bytesPerPixel > 0 ? bytesPerPixel : 4);
+}
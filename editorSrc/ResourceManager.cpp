@@ -1,10 +1,11 @@
 
+#include <algorithm>
 #include "ResourceManager.hpp"
 
 // initialize the singleton pointer field
 ResourceManager* ResourceManager::instance = nullptr;
 
-ResourceManager::ResourceManager(){}
+ResourceManager::ResourceManager():sprite_pool(SPRITE_POOL_SIZE, POOL_POISON){}
 
 
 ResourceManager::~ResourceManager(){}
@@ -13,9 +14,10 @@ void ResourceManager::destroy() {
 	
 	for( auto it = loaded_resources.begin(); it != loaded_resources.end(); ++it )
     {
-	    delete (Sprite*) (it->second);
+	    sprite_pool.Release(it->second);
     }
     loaded_resources.clear();
+    active_sprites.Clear();
     
 }
 
@@ -34,23 +36,50 @@ void ResourceManager::load_resource() {
 	//std::string resource_path = "./sprite.bmp";
 	// if the resource is a new one, load it to a map
 	// if new resource
-	loaded_resources[IMG_FILES::CHAR_IDLE_SPRITE_ID] = new Sprite(CHAR_IDLE_SPRITE, renderer, CHAR_IDLE_IMG_INFO);
-	loaded_resources[IMG_FILES::CHAR_WALK_SPRITE_ID] = new Sprite(CHAR_WALK_SPRITE, renderer, CHAR_WALK_IMG_INFO);
-	loaded_resources[IMG_FILES::CHAR_JUMP_SPRITE_ID] = new Sprite(CHAR_JUMP_SPRITE, renderer, CHAR_JUMP_IMG_INFO);
-	loaded_resources[IMG_FILES::CHAR_FALL_SPRITE_ID] = new Sprite(CHAR_FALL_SPRITE, renderer, CHAR_FALL_IMG_INFO);
-	loaded_resources[IMG_FILES::CHAR_HIT_SPRITE_ID] = new Sprite(CHAR_HIT_SPRITE, renderer, CHAR_HIT_IMG_INFO);
-	loaded_resources[IMG_FILES::ENEMY_WALK_SPRITE_ID] = new Sprite(ENEMY_WALK_SPRITE, renderer, ENEMY_WALK_IMG_INFO);
-	loaded_resources[IMG_FILES::ENEMY_IDLE_SPRITE_ID] = new Sprite(ENEMY_IDLE_SPRITE, renderer, ENEMY_IDLE_IMG_INFO);
-	loaded_resources[IMG_FILES::ENEMY_RUN_SPRITE_ID] = new Sprite(ENEMY_RUN_SPRITE, renderer, ENEMY_RUN_IMG_INFO);
-	loaded_resources[IMG_FILES::ENEMY_HIT_SPRITE_ID] = new Sprite(ENEMY_HIT_SPRITE, renderer, ENEMY_HIT_IMG_INFO);
-	loaded_resources[IMG_FILES::BACKGROUND_IMG_FILE_ID] = new Sprite(BACKGROUND_IMG_FILE, renderer, STILL_SPRITE_INFO);
+	loaded_resources[IMG_FILES::CHAR_IDLE_SPRITE_ID] = sprite_pool.Acquire(CHAR_IDLE_SPRITE, renderer, CHAR_IDLE_IMG_INFO);
+	loaded_resources[IMG_FILES::CHAR_WALK_SPRITE_ID] = sprite_pool.Acquire(CHAR_WALK_SPRITE, renderer, CHAR_WALK_IMG_INFO);
+	loaded_resources[IMG_FILES::CHAR_JUMP_SPRITE_ID] = sprite_pool.Acquire(CHAR_JUMP_SPRITE, renderer, CHAR_JUMP_IMG_INFO);
+	loaded_resources[IMG_FILES::CHAR_FALL_SPRITE_ID] = sprite_pool.Acquire(CHAR_FALL_SPRITE, renderer, CHAR_FALL_IMG_INFO);
+	loaded_resources[IMG_FILES::CHAR_HIT_SPRITE_ID] = sprite_pool.Acquire(CHAR_HIT_SPRITE, renderer, CHAR_HIT_IMG_INFO);
+	loaded_resources[IMG_FILES::ENEMY_WALK_SPRITE_ID] = sprite_pool.Acquire(ENEMY_WALK_SPRITE, renderer, ENEMY_WALK_IMG_INFO);
+	loaded_resources[IMG_FILES::ENEMY_IDLE_SPRITE_ID] = sprite_pool.Acquire(ENEMY_IDLE_SPRITE, renderer, ENEMY_IDLE_IMG_INFO);
+	loaded_resources[IMG_FILES::ENEMY_RUN_SPRITE_ID] = sprite_pool.Acquire(ENEMY_RUN_SPRITE, renderer, ENEMY_RUN_IMG_INFO);
+	loaded_resources[IMG_FILES::ENEMY_HIT_SPRITE_ID] = sprite_pool.Acquire(ENEMY_HIT_SPRITE, renderer, ENEMY_HIT_IMG_INFO);
+	loaded_resources[IMG_FILES::BACKGROUND_IMG_FILE_ID] = sprite_pool.Acquire(BACKGROUND_IMG_FILE, renderer, STILL_SPRITE_INFO);
 }
 
 
 void ResourceManager::update(int id){
 	loaded_resources[id]->Update();
+	// keep the spatial hash in step with the sprite's position
+	active_sprites.Move(id, loaded_resources[id]->GetBounds());
 }
 
 void ResourceManager::render(int id, SDL_Renderer* ren){
 	loaded_resources[id]->Render(ren);
 }
+
+void ResourceManager::set_active(int id, bool active){
+	if (loaded_resources.find(id) == loaded_resources.end()) return;
+	if (!active) {
+		active_sprites.Remove(id);
+		return;
+	}
+	Uint32 layer = LAYER_SCENERY;
+	if (id >= CHAR_IDLE_SPRITE_ID && id <= CHAR_HIT_SPRITE_ID) layer = LAYER_PLAYER;
+	else if (id >= ENEMY_WALK_SPRITE_ID && id <= ENEMY_HIT_SPRITE_ID) layer = LAYER_ENEMY;
+	active_sprites.Insert(id, loaded_resources[id]->GetBounds(), layer);
+}
+
+void ResourceManager::find_overlaps(Uint32 layers_a, Uint32 layers_b, std::vector<std::pair<int, int>> &out){
+	active_sprites.QueryPairs(layers_a, layers_b, out);
+}
+
+void ResourceManager::render_visible(SDL_Renderer* ren, const Camera &camera){
+	active_sprites.Query(camera.GetView(), visible_ids);
+	// draw in id order so overlapping sprites do not flicker with hash order
+	std::sort(visible_ids.begin(), visible_ids.end());
+	for (int id : visible_ids) {
+		loaded_resources[id]->Render(ren, camera);
+	}
+}
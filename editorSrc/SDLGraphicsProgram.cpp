@@ -1,9 +1,29 @@
 
 #include "SDLGraphicsProgram.hpp"
+
+// the sprites the number keys select, in the order of their keys
+const std::string SPRITE_MENU[] = {
+    "[0] Character idle",
+    "[1] Character walk",
+    "[2] Character jump",
+    "[3] Character fall",
+    "[4] Character idle",
+    "[5] Enemy walk",
+    "[6] Enemy idle",
+    "[7] Enemy run",
+    "[8] Enemy hit"
+};
+const int SPRITE_MENU_SIZE = sizeof(SPRITE_MENU) / sizeof(SPRITE_MENU[0]);
+
+// modifier keys come down on their own before the key they modify, as in ctrl+z
+static bool IsModifierKey(SDL_Keycode sym) {
+    return (sym >= SDLK_LCTRL && sym <= SDLK_RGUI) || sym == SDLK_CAPSLOCK || sym == SDLK_MODE;
+}
+
 // Initialization function
 // Returns a true or false value based on successful completion of setup.
 // Takes in dimensions of window.
-SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight(h){
+SDLGraphicsProgram::SDLGraphicsProgram(int w, int h, const RunOptions &options):screenWidth(w),screenHeight(h),options(options){
   	// Initialize random number generation.
    	srand(time(NULL));
 
@@ -14,6 +34,11 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight
 	// The window we'll be rendering to
 	gWindow = NULL;
 	// Render flag
+    // headless runs draw to a window that is never shown and play to no audio device
+    if (options.headless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
 	// Initialize SDL
 	if(SDL_Init(SDL_INIT_EVERYTHING)< 0){
@@ -22,7 +47,7 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight
 	}
 	else{
 		//Create window
-		gWindow = SDL_CreateWindow( "Lab", 100, 100, screenWidth, screenHeight, SDL_WINDOW_SHOWN );
+		gWindow = SDL_CreateWindow( "Lab", 100, 100, screenWidth, screenHeight, options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN );
 
 		// Check if Window did not create.
 		if( gWindow == NULL ){
@@ -31,7 +56,8 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight
 		}
 
 		//Create a Renderer to draw on
-		gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+		// the tile map bakes its chunks into render target textures
+		gRenderer = SDL_CreateRenderer(gWindow, -1, (options.headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED) | SDL_RENDERER_TARGETTEXTURE);
 		// Check if Renderer did not create.
 		if( gRenderer == NULL ){
 			errorStream << "Renderer could not be created! SDL Error: " << SDL_GetError() << "\n";
@@ -46,6 +72,34 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight
         success = false;
     }
 
+    // load the MP3 decoder now rather than when the music starts
+    if (!(Mix_Init(MIX_INIT_MP3) & MIX_INIT_MP3)) {
+        errorStream << "SDL_mixer could not load the MP3 decoder! SDL_mixer Error: " << Mix_GetError() << "\n";
+        success = false;
+    }
+    if (Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, AUDIO_CHANNELS, AUDIO_BUFFER_FRAMES) < 0) {
+        errorStream << "Audio device could not be opened! SDL_mixer Error: " << Mix_GetError() << "\n";
+        success = false;
+    } else {
+        bool mixing = audioMixer.Start();
+        if (!mixing) {
+            errorStream << "Sound effects could not be mixed into the audio device\n";
+            success = false;
+        }
+        paintSound = audioMixer.AddTone(880, 0.04f);
+        fillSound = audioMixer.AddTone(440, 0.2f);
+        // voices on a mixer the device never runs would never be reported as over
+        if (mixing) voiceManager.SetMixer(&audioMixer);
+        // a fill is rare and worth hearing, paint clicks may be cut short by it
+        voiceManager.SetSoundRules(paintSound, 0, 2);
+        voiceManager.SetSoundRules(fillSound, 1, 1);
+        musicPlayer.SetVolume(MUSIC_VOLUME);
+        if (!musicPlayer.Play(MUSIC_FILE)) {
+            errorStream << "Music could not be played: " << MUSIC_FILE << "\n";
+            success = false;
+        }
+    }
+
     // Setup our characters
     // Remember, this can only be done after SDL has been
     // successfully initialized!
@@ -57,6 +111,69 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h):screenWidth(w),screenHeight
 
     ResourceManager::get_instance()->load_resource();
 
+    // load the level and the tile sheet it is drawn with
+    // the shipped levels are mostly empty, keep only the chunks with tiles, run length encoded
+    tileMap.SetStorage(STORAGE_SPARSE);
+    // edits autosaved before the editor was last closed or crashed come back whole,
+    // otherwise binary levels are streamed around the view and text levels are loaded whole
+    // recorded and replayed sessions start from the level on disk, loaded whole,
+    // so that neither an autosave nor the timing of streamed chunks changes what they edit
+    bool deterministic = !options.recordPath.empty() || !options.replayPath.empty();
+    if (options.discardAutosave) Autosaver::Discard(DEFAULT_LEVEL_FILE);
+    if (deterministic) {
+        if (!tileMap.LoadFromFile(DEFAULT_LEVEL_FILE)) {
+            errorStream << "Level could not be loaded: " << DEFAULT_LEVEL_FILE << "\n";
+            success = false;
+        }
+    } else if (Autosaver::HasAutosave(DEFAULT_LEVEL_FILE)) {
+        if (Autosaver::Recover(DEFAULT_LEVEL_FILE, tileMap)) {
+            std::cout << "Recovered the autosave of " << DEFAULT_LEVEL_FILE << "\n";
+        } else {
+            errorStream << "Autosave could not be recovered: " << DEFAULT_LEVEL_FILE << "\n";
+            success = false;
+        }
+    } else if (LevelFile::IsLevelFile(DEFAULT_LEVEL_FILE)) {
+        if (!chunkStreamer.Open(DEFAULT_LEVEL_FILE, &tileMap)) {
+            errorStream << "Level could not be streamed: " << DEFAULT_LEVEL_FILE << "\n";
+            success = false;
+        }
+    } else if (!tileMap.LoadFromFile(DEFAULT_LEVEL_FILE)) {
+        errorStream << "Level could not be loaded: " << DEFAULT_LEVEL_FILE << "\n";
+        success = false;
+    }
+    if (!tileMapRenderer.Init(gRenderer, TILE_SHEET_FILE)) {
+        errorStream << "Tile sheet could not be loaded! SDL Error: " << SDL_GetError() << "\n";
+        success = false;
+    }
+    tileMapRenderer.SetTileMap(&tileMap);
+    perfOverlay.SetInputLatency(&inputLatency);
+    if (!textRenderer.Init(gRenderer, FONT_FILE, FONT_SIZE)) {
+        errorStream << "Font could not be loaded: " << FONT_FILE << "\n";
+        success = false;
+    }
+    collisionMap.Build(tileMap);
+    tileMap.SetJournal(&journal);
+    if (!deterministic) autosaver.Start(DEFAULT_LEVEL_FILE, tileMap);
+    // edited chunks are paged out only once the autosave has them
+    chunkStreamer.SetAutosaver(&autosaver);
+    if (!options.replayPath.empty()) {
+        if (!replayer.Open(options.replayPath)) {
+            errorStream << "Input log could not be replayed: " << options.replayPath << "\n";
+            success = false;
+        } else if (replayer.GetUpdatesPerSecond() != (Uint32)UPDATES_PER_SECOND) {
+            std::cout << "Input log was recorded at " << replayer.GetUpdatesPerSecond() << " updates per second, replaying at "
+                      << UPDATES_PER_SECOND << "\n";
+        }
+    } else if (!options.recordPath.empty() && !recorder.Open(options.recordPath)) {
+        errorStream << "Input log could not be created: " << options.recordPath << "\n";
+        success = false;
+    }
+
+    // the camera shows a window sized part of the level and never leaves it
+    camera.SetViewport(screenWidth, screenHeight);
+    camera.SetBounds(tileMap.GetWidth() * TILE_SIZE, tileMap.GetHeight() * TILE_SIZE);
+    ResourceManager::get_instance()->set_active(spriteID, true);
+
 
   // If initialization did not work, then print out a list of errors in the constructor.
   if(!success){
@@ -75,6 +192,27 @@ SDLGraphicsProgram::~SDLGraphicsProgram(){}
 void SDLGraphicsProgram::destroy(){
     // Destroy Renderer
     ResourceManager::get_instance()->destroy();
+    if (recorder.IsOpen()) {
+        if (recorder.Close(tickCount, levelChecksum())) {
+            std::cout << "Recorded " << tickCount << " updates of input to " << options.recordPath << "\n";
+        } else {
+            std::cout << "Input log could not be written: " << options.recordPath << "\n";
+        }
+    }
+    // write out the edits of the last interval before quitting
+    autosaver.Flush(tileMap);
+    autosaver.Stop();
+    chunkStreamer.Close();
+    // the level unloads here
+    GetLevelArena().Release();
+    tileMapRenderer.Destroy();
+    textRenderer.Destroy();
+    if (inputLatency.GetCount() > 0) inputLatency.Report(std::cout);
+    voiceManager.StopAll();
+    audioMixer.Stop();
+    musicPlayer.Stop();
+    Mix_CloseAudio();
+    Mix_Quit();
 
     SDL_DestroyRenderer(gRenderer);
     //Destroy window
@@ -91,9 +229,27 @@ void SDLGraphicsProgram::destroy(){
 // Update OpenGL
 void SDLGraphicsProgram::update()
 {
-    
+    // a replayed session applies the events of this tick exactly where the recording did;
+    // its quit key is ignored, the replay ends at the recorded last tick instead
+    if (replayer.IsOpen()) {
+        if (replayer.IsFinished(tickCount)) return;
+        SDL_Event event;
+        bool replayedQuit = false;
+        while (replayer.Next(tickCount, event)) {
+            handleEvent(event, &replayedQuit);
+        }
+    }
     ResourceManager::get_instance()->update(spriteID);
-
+    // re-encode the chunks edited since the last update
+    tileMap.Compact();
+    // bring the solid tiles in line with edited and streamed chunks
+    collisionMap.Update(tileMap);
+    autosaver.Update(tileMap);
+    // start the sound effects triggered since the last update, heard from the middle of the view
+    const SDL_Rect &view = camera.GetView();
+    voiceManager.SetListener(view.x + view.w / 2, view.y + view.h / 2);
+    voiceManager.Update();
+    tickCount++;
 }
 
 // Render
@@ -102,13 +258,19 @@ void SDLGraphicsProgram::render(){
 
     SDL_SetRenderDrawColor(gRenderer, 0x22,0x22,0x22,0xFF);
     SDL_RenderClear(gRenderer);
-    ResourceManager::get_instance()->render(spriteID, getSDLRenderer());
+    chunkStreamer.Update(camera.GetView());
+    tileMapRenderer.Render(gRenderer, camera);
+    ResourceManager::get_instance()->render_visible(getSDLRenderer(), camera);
+    renderMenu();
+    perfOverlay.Render(gRenderer, textRenderer, 0, screenHeight);
     SDL_RenderPresent(gRenderer);
+    inputLatency.OnPresent(SDL_GetTicks());
+    RenderStats::EndFrame();
 }
 
 // the Update() helper function that provide a frame stablizer
 // adapted from my lab 1
-void SDLGraphicsProgram::update_with_timer(std::chrono::steady_clock::time_point &previous_time, double &elapsed_time_total, int &frame_counter, double &lag, double mcs_per_update) {
+void SDLGraphicsProgram::update_with_timer(std::chrono::steady_clock::time_point &previous_time, double &elapsed_time_total, int &frame_counter, double &lag, double mcs_per_update, bool *quit) {
     // time recorders
     //std::cout << "prev time: " << std::chrono::duration_cast<std::chrono::minutes>(previous_time).count();
     std::chrono::steady_clock::time_point current_time;
@@ -122,19 +284,32 @@ void SDLGraphicsProgram::update_with_timer(std::chrono::steady_clock::time_point
     previous_time = current_time;
     // record overall time spend (in microseconds)
     elapsed_time_total += elapsed_time;
-    // stablizer switch
-    if(stable_frame) {
+    updateSteps = 0;
+    // stablizer switch, uncapped runs go as fast as the updates allow
+    if(stable_frame && !options.uncapped) {
         // if the last update/render loop spent more than fps limit (16.67ms for 60 fps)
         // we update untill the game progress catches up
         lag += elapsed_time;
+        // input is read right before the last update of the frame instead of before
+        // the catch-up updates, so the frame rendered next shows the newest input
+        bool input_read = false;
         while(lag >= mcs_per_update) {
+            if (lag < 2 * mcs_per_update) {
+                processInput(quit);
+                input_read = true;
+            }
             // Update our scene
             update();
+            updateSteps++;
             lag -= mcs_per_update;
             frame_counter++;
         }
+        // frames without an update still react to input before they are rendered
+        if (!input_read) processInput(quit);
     } else {
+        processInput(quit);
         update();
+        updateSteps++;
         frame_counter++;
     }
     // for every 1 second, report frame rate and re-initialize counters
@@ -165,7 +340,7 @@ void SDLGraphicsProgram::loop(){
     // ===============================================================
     // use MAGIC NUMBER to make sure sprite with less grids run slower
     // ===============================================================
-    int frame_rate = 60;
+    int frame_rate = UPDATES_PER_SECOND;
     double mcs_per_update = mcs_per_second / frame_rate;
     // elapsed_time_total - measure total time elapsed
     // lag - accumulate elapsed time for determining when to update to ensure steady frame rate
@@ -178,22 +353,84 @@ void SDLGraphicsProgram::loop(){
     previous_time = std::chrono::steady_clock::now();
     // While application is running
 
-    promptMsg();
+    if (!options.headless) promptMsg();
+    std::chrono::steady_clock::time_point run_start = std::chrono::steady_clock::now();
+    // a fast-forward runs its updates and quits before the loop
+    if (options.fastForwardTicks > 0) fastForward(&quit);
     // While application is running
     while(!quit){
-      processInput(&quit);
+      std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
       // Update our scene
       // update with a frame stablizer
-      update_with_timer(previous_time, elapsed_time_total, frame_counter, lag, mcs_per_update);
+      update_with_timer(previous_time, elapsed_time_total, frame_counter, lag, mcs_per_update, &quit);
       // Render using OpenGL
-      render();
+      std::chrono::steady_clock::time_point render_start = std::chrono::steady_clock::now();
+      if (!options.headless) render();
       //Update screen of our specified window
+      std::chrono::steady_clock::time_point frame_end = std::chrono::steady_clock::now();
+      // the overlay shows this frame from the next one on
+      typedef std::chrono::duration<double, std::milli> milliseconds;
+      perfOverlay.RecordFrame(milliseconds(frame_end - frame_start).count(),
+                              milliseconds(render_start - frame_start).count(),
+                              milliseconds(frame_end - render_start).count(), updateSteps);
+      // events no frame was presented for are not measured
+      inputLatency.ClearPending();
+      // the temporary data of this iteration is no longer used
+      GetFrameArena().Reset();
+    }
+
+    if (replayer.IsOpen()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+        std::cout << "Replayed " << tickCount << " updates in " << seconds << "s, "
+                  << (seconds > 0 ? tickCount / seconds : 0.0) << " updates/s\n";
+        if (!replayer.HasEnd()) {
+            std::cout << "The input log has no end, the level cannot be checked\n";
+        } else if (levelChecksum() == replayer.GetLevelChecksum()) {
+            std::cout << "The level matches the recording\n";
+        } else {
+            std::cout << "The level does NOT match the recording: " << std::hex << levelChecksum()
+                      << " instead of " << replayer.GetLevelChecksum() << std::dec << "\n";
+        }
     }
 
     //Disable text input
     SDL_StopTextInput();
 }
 
+void SDLGraphicsProgram::fastForward(bool *quit) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Uint32 firstTick = tickCount;
+    int framesRendered = 0;
+    while (!*quit && tickCount - firstTick < (Uint32)options.fastForwardTicks) {
+        // pumping the window events costs more than an update, once per simulated second keeps the window alive
+        if ((tickCount - firstTick) % UPDATES_PER_SECOND == 0) processInput(quit);
+        if (replayer.IsOpen() && replayer.IsFinished(tickCount)) break;
+        update();
+        if (options.renderEvery > 0 && !options.headless && (tickCount - firstTick) % options.renderEvery == 0) {
+            render();
+            framesRendered++;
+        }
+        GetFrameArena().Reset();
+        if ((tickCount - firstTick) % FAST_FORWARD_REPORT_TICKS == 0) {
+            std::cout << "  " << (tickCount - firstTick) << " updates, peak memory "
+                      << GetPeakMemoryBytes() / (1024.0 * 1024.0) << "MB\n";
+        }
+    }
+    *quit = true;
+
+    Uint32 ticks = tickCount - firstTick;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double simulatedSeconds = (double)ticks / UPDATES_PER_SECOND;
+    std::cout << "Fast-forwarded " << ticks << " updates, " << simulatedSeconds << "s of simulated time, in "
+              << seconds << "s\n";
+    if (seconds > 0) {
+        std::cout << "  " << ticks / seconds << " updates/s, " << simulatedSeconds / seconds << "x real time\n";
+    }
+    std::cout << "  " << framesRendered << " frames rendered, peak memory "
+              << GetPeakMemoryBytes() / (1024.0 * 1024.0) << "MB, frame arena peak "
+              << GetFrameArena().GetPeakBytes() / 1024.0 << "KB\n";
+}
+
 // Get Pointer to Window
 SDL_Window* SDLGraphicsProgram::getSDLWindow(){
   return gWindow;
@@ -206,63 +443,196 @@ SDL_Renderer* SDLGraphicsProgram::getSDLRenderer(){
 
 void SDLGraphicsProgram::promptMsg() {
     std::cout << "Please select a sprite:" << std::endl;
-    std::cout << "[0] Character idle" << std::endl;
-    std::cout << "[1] Character walk" << std::endl;
-    std::cout << "[2] Character jump" << std::endl;
-    std::cout << "[3] Character fall" << std::endl;
-    std::cout << "[4] Character idle" << std::endl;
-    std::cout << "[5] Enemy walk" << std::endl;
-    std::cout << "[6] Enemy idle" << std::endl;
-    std::cout << "[7] Enemy run" << std::endl;
-    std::cout << "[8] Enemy hit" << std::endl;
+    for (int i = 0; i < SPRITE_MENU_SIZE; i++) {
+        std::cout << SPRITE_MENU[i] << std::endl;
+    }
+    std::cout << "Press m to show the menu in the window, p for performance numbers, b to pause the music" << std::endl;
+}
+
+void SDLGraphicsProgram::renderMenu() {
+    const SDL_Color normal {0xFF, 0xFF, 0xFF, 0xFF};
+    const SDL_Color selected {0xFF, 0xD8, 0x40, 0xFF};
+    // every line is a static string, its layout is only built the first time it is drawn
+    int first = showMenu ? 0 : spriteID, last = showMenu ? SPRITE_MENU_SIZE : spriteID + 1;
+    if (first < 0 || last > SPRITE_MENU_SIZE) return;
+    int width = 0;
+    for (int i = first; i < last; i++) {
+        width = std::max(width, textRenderer.GetLayout(SPRITE_MENU[i]).width);
+    }
+    int lineHeight = textRenderer.GetLineHeight();
+    SDL_Rect panel {0, 0, width + 4, (last - first) * lineHeight + 4};
+    SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xFF);
+    SDL_RenderFillRect(gRenderer, &panel);
+    RenderStats::CountDrawCalls();
+    for (int i = first; i < last; i++) {
+        textRenderer.DrawText(gRenderer, SPRITE_MENU[i], 2, 2 + (i - first) * lineHeight, i == spriteID ? selected : normal);
+    }
 }
 
 void SDLGraphicsProgram::processInput(bool *quit) {
     SDL_Event event;
-    SDL_StartTextInput();
     while (SDL_PollEvent(&event) != 0) {
         if (event.type == SDL_QUIT) {
             *quit = true;
             return;
         }
-        if (event.type == SDL_KEYDOWN) {
-            switch (event.key.keysym.sym) {
-                case SDLK_q:
-                    *quit = true;
-                    break;
-                case SDLK_0:
-                    spriteID = CHAR_IDLE_SPRITE_ID;
-                    break;
-                case SDLK_1:
-                    spriteID = CHAR_WALK_SPRITE_ID;
-                    break;
-                case SDLK_2:
-                    spriteID = CHAR_JUMP_SPRITE_ID;
-                    break;
-                case SDLK_3:
-                    spriteID = CHAR_FALL_SPRITE_ID;
-                    break;
-                case SDLK_4:
-                    spriteID = CHAR_HIT_SPRITE_ID;
-                    break;
-                case SDLK_5:
-                    spriteID = ENEMY_WALK_SPRITE_ID;
-                    break;
-                case SDLK_6:
-                    spriteID = ENEMY_IDLE_SPRITE_ID;
-                    break;
-                case SDLK_7:
-                    spriteID = ENEMY_RUN_SPRITE_ID;
-                    break;
-                case SDLK_8:
-                    spriteID = ENEMY_HIT_SPRITE_ID;
-                    break;
-                default:
-                    spriteID = ENEMY_RUN_SPRITE_ID;
-                    std::cout << std::endl << ">>>>>>>>Invalid ID!<<<<<<<" << std::endl << std::endl;
-                    promptMsg();
+        // render target contents are lost e.g. when the device is reset
+        if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+            tileMapRenderer.InvalidateAll();
+        }
+        // a replay takes its input from the log only
+        if (replayer.IsOpen()) continue;
+        // events are recorded against the update they are applied before
+        recorder.Record(tickCount, event);
+        // the live events the editor visibly reacts to count towards input latency, but only
+        // when every loop presents a frame; fast-forwards present one frame for many updates
+        if (!options.headless && options.fastForwardTicks == 0
+            && (event.type == SDL_KEYDOWN || event.type == SDL_MOUSEBUTTONDOWN
+                || (event.type == SDL_MOUSEMOTION && (event.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))))) {
+            inputLatency.OnEvent(event.common.timestamp);
+        }
+        handleEvent(event, quit);
+    }
+    if (replayer.IsOpen() && replayer.IsFinished(tickCount)) *quit = true;
+}
+
+void SDLGraphicsProgram::handleEvent(const SDL_Event &event, bool *quit) {
+    int previousSpriteID = spriteID;
+    // the mouse position comes from the events rather than the device, so it replays too
+    if (event.type == SDL_MOUSEMOTION) {
+        mouseX = event.motion.x;
+        mouseY = event.motion.y;
+    } else if (event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
+        mouseX = event.button.x;
+        mouseY = event.button.y;
+    }
+    // the left mouse button paints terrain and the right one erases it
+    // everything painted until the button is let go is undone together
+    if (event.type == SDL_MOUSEBUTTONDOWN && (event.button.button == SDL_BUTTON_LEFT || event.button.button == SDL_BUTTON_RIGHT)) {
+        journal.BeginTransaction();
+        voiceManager.Trigger(paintSound, 0.5f);
+        paintTerrain(event.button.x, event.button.y, event.button.button == SDL_BUTTON_LEFT);
+    }
+    if (event.type == SDL_MOUSEBUTTONUP) {
+        journal.EndTransaction();
+    }
+    if (event.type == SDL_MOUSEMOTION && (event.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON_RMASK))) {
+        paintTerrain(event.motion.x, event.motion.y, event.motion.state & SDL_BUTTON_LMASK);
+    }
+    if (event.type == SDL_KEYDOWN) {
+        switch (event.key.keysym.sym) {
+            case SDLK_q:
+                *quit = true;
+                break;
+            // ctrl+z undoes the last stroke, ctrl+y redoes it
+            case SDLK_z:
+                if (event.key.keysym.mod & KMOD_CTRL) journal.Undo(tileMap);
+                break;
+            case SDLK_y:
+                if (event.key.keysym.mod & KMOD_CTRL) journal.Redo(tileMap);
+                break;
+            case SDLK_f:
+                fillTerrain();
+                break;
+            case SDLK_m:
+                showMenu = !showMenu;
+                break;
+            case SDLK_p:
+                perfOverlay.Toggle();
+                break;
+            case SDLK_b:
+                musicPlayer.TogglePause();
+                break;
+            // arrow keys pan the camera by one tile
+            case SDLK_LEFT:
+                camera.Move(-TILE_SIZE, 0);
+                break;
+            case SDLK_RIGHT:
+                camera.Move(TILE_SIZE, 0);
+                break;
+            case SDLK_UP:
+                camera.Move(0, -TILE_SIZE);
+                break;
+            case SDLK_DOWN:
+                camera.Move(0, TILE_SIZE);
+                break;
+            case SDLK_0:
+                spriteID = CHAR_IDLE_SPRITE_ID;
+                break;
+            case SDLK_1:
+                spriteID = CHAR_WALK_SPRITE_ID;
+                break;
+            case SDLK_2:
+                spriteID = CHAR_JUMP_SPRITE_ID;
+                break;
+            case SDLK_3:
+                spriteID = CHAR_FALL_SPRITE_ID;
+                break;
+            case SDLK_4:
+                spriteID = CHAR_HIT_SPRITE_ID;
+                break;
+            case SDLK_5:
+                spriteID = ENEMY_WALK_SPRITE_ID;
+                break;
+            case SDLK_6:
+                spriteID = ENEMY_IDLE_SPRITE_ID;
+                break;
+            case SDLK_7:
+                spriteID = ENEMY_RUN_SPRITE_ID;
+                break;
+            case SDLK_8:
+                spriteID = ENEMY_HIT_SPRITE_ID;
+                break;
+            // any other key keeps the selected sprite
+            default:
+                if (IsModifierKey(event.key.keysym.sym)) break;
+                std::cout << std::endl << ">>>>>>>>Invalid ID!<<<<<<<" << std::endl << std::endl;
+                promptMsg();
+        }
+    }
+    // only the selected sprite is shown in the level
+    if (spriteID != previousSpriteID) {
+        ResourceManager::get_instance()->set_active(previousSpriteID, false);
+        ResourceManager::get_instance()->set_active(spriteID, true);
+    }
+}
 
-            }
-        } 
+void SDLGraphicsProgram::paintTerrain(int screenX, int screenY, bool terrain) {
+    const SDL_Rect &view = camera.GetView();
+    int levelX = view.x + screenX, levelY = view.y + screenY;
+    if (levelX < 0 || levelY < 0) return;
+    autotiler.Paint(tileMap, levelX / TILE_SIZE, levelY / TILE_SIZE, terrain);
+}
+
+void SDLGraphicsProgram::fillTerrain() {
+    const SDL_Rect &view = camera.GetView();
+    int levelX = view.x + mouseX, levelY = view.y + mouseY;
+    if (levelX < 0 || levelY < 0) return;
+
+    journal.BeginTransaction();
+    voiceManager.Trigger(fillSound, 0.5f);
+    TileChangeSet changes = FloodFill(tileMap, levelX / TILE_SIZE, levelY / TILE_SIZE, TILES1_ROCK_LAYOUT.center);
+    if (!changes.IsEmpty()) {
+        // the fill and the edges around it are one change for undo and for the collision mask
+        SDL_Rect area = changes.area;
+        autotiler.Retile(tileMap, {area.x - 1, area.y - 1, area.w + 2, area.h + 2}, &changes);
+        changes.Finish();
+        collisionMap.Apply(tileMap, changes);
+    }
+    journal.EndTransaction();
+}
+
+Uint32 SDLGraphicsProgram::levelChecksum() const {
+    // FNV-1a over the tiles row by row, the same for every storage of the level
+    Uint32 hash = 2166136261u;
+    std::vector<TileID> row(tileMap.GetWidth());
+    for (int y = 0; y < tileMap.GetHeight(); y++) {
+        tileMap.CopyRowSpan(0, y, row.data(), (int)row.size());
+        // low byte first, so recordings compare across platforms
+        for (TileID tile : row) {
+            hash = (hash ^ ((Uint16)tile & 0xFF)) * 16777619u;
+            hash = (hash ^ ((Uint16)tile >> 8)) * 16777619u;
+        }
     }
-}
\ No newline at end of file
+    return hash;
+}
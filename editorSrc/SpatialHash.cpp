@@ -0,0 +1,139 @@
+/**
+ * @file SpatialHash.cpp
+ * @brief This file contains a uniform grid that finds the entities inside an area.
+ */
+#include <algorithm>
+#include "SpatialHash.hpp"
+
+SpatialHash::SpatialHash(int cellSize):cellSize(std::max(1, cellSize)),queryStamp(0) {
+}
+
+SpatialHash::~SpatialHash() {
+}
+
+void SpatialHash::Insert(int id, const SDL_Rect &bounds, Uint32 layers) {
+    if (id < 0) return;
+    if (id >= (int)entries.size()) entries.resize(id + 1, Entry{{0, 0, 0, 0}, {0, 0, -1, -1}, 0, false, 0});
+    Entry &entry = entries[id];
+    entry.layers = layers;
+    if (entry.present) {
+        Move(id, bounds);
+        return;
+    }
+    entry.bounds = bounds;
+    entry.cells = SpanOf(bounds);
+    entry.present = true;
+    AddTo(id, entry.cells, nullptr);
+}
+
+void SpatialHash::Move(int id, const SDL_Rect &bounds) {
+    if (!Contains(id)) return;
+    Entry &entry = entries[id];
+    CellSpan span = SpanOf(bounds);
+    entry.bounds = bounds;
+    if (span.firstX == entry.cells.firstX && span.firstY == entry.cells.firstY
+        && span.lastX == entry.cells.lastX && span.lastY == entry.cells.lastY) return;
+    // only the cells that were left or entered change
+    RemoveFrom(id, entry.cells, &span);
+    AddTo(id, span, &entry.cells);
+    entry.cells = span;
+}
+
+void SpatialHash::Remove(int id) {
+    if (!Contains(id)) return;
+    RemoveFrom(id, entries[id].cells, nullptr);
+    entries[id].present = false;
+}
+
+bool SpatialHash::Contains(int id) const {
+    return id >= 0 && id < (int)entries.size() && entries[id].present;
+}
+
+void SpatialHash::Query(const SDL_Rect &area, std::vector<int> &out) const {
+    out.clear();
+    queryStamp++;
+    int firstX = FloorDiv(area.x, cellSize), lastX = FloorDiv(area.x + area.w - 1, cellSize);
+    int firstY = FloorDiv(area.y, cellSize), lastY = FloorDiv(area.y + area.h - 1, cellSize);
+    for (int cellY = firstY; cellY <= lastY; cellY++) {
+        for (int cellX = firstX; cellX <= lastX; cellX++) {
+            auto cell = cells.find(CellKey(cellX, cellY));
+            if (cell == cells.end()) continue;
+            for (int id : cell->second) {
+                Entry &entry = entries[id];
+                if (entry.queryStamp == queryStamp) continue;
+                entry.queryStamp = queryStamp;
+                const SDL_Rect &b = entry.bounds;
+                // the cell overlaps the area, the box itself may not
+                if (b.x < area.x + area.w && b.x + b.w > area.x && b.y < area.y + area.h && b.y + b.h > area.y) {
+                    out.push_back(id);
+                }
+            }
+        }
+    }
+}
+
+void SpatialHash::QueryPairs(Uint32 layersA, Uint32 layersB, std::vector<std::pair<int, int>> &out) const {
+    out.clear();
+    for (const auto &cell : cells) {
+        const std::vector<int> &ids = cell.second;
+        int cellX = (int)(Uint32)(cell.first >> 32);
+        int cellY = (int)(Uint32)cell.first;
+        for (size_t i = 0; i < ids.size(); i++) {
+            const Entry &first = entries[ids[i]];
+            for (size_t j = i + 1; j < ids.size(); j++) {
+                const Entry &second = entries[ids[j]];
+                bool firstLeads = (first.layers & layersA) && (second.layers & layersB);
+                bool secondLeads = (second.layers & layersA) && (first.layers & layersB);
+                if (!firstLeads && !secondLeads) continue;
+                // two boxes that overlap share several cells, the pair is only
+                // reported from the one holding the top left of their overlap
+                if (std::max(first.cells.firstX, second.cells.firstX) != cellX
+                    || std::max(first.cells.firstY, second.cells.firstY) != cellY) continue;
+                const SDL_Rect &a = first.bounds, &b = second.bounds;
+                if (!(a.x < b.x + b.w && a.x + a.w > b.x && a.y < b.y + b.h && a.y + a.h > b.y)) continue;
+                if (firstLeads && secondLeads) out.emplace_back(std::min(ids[i], ids[j]), std::max(ids[i], ids[j]));
+                else if (firstLeads) out.emplace_back(ids[i], ids[j]);
+                else out.emplace_back(ids[j], ids[i]);
+            }
+        }
+    }
+    // hash map order is not stable, callers get the same answer every frame
+    std::sort(out.begin(), out.end());
+}
+
+void SpatialHash::Clear() {
+    cells.clear();
+    entries.clear();
+}
+
+SpatialHash::CellSpan SpatialHash::SpanOf(const SDL_Rect &bounds) const {
+    return {FloorDiv(bounds.x, cellSize), FloorDiv(bounds.y, cellSize),
+            FloorDiv(bounds.x + std::max(bounds.w, 1) - 1, cellSize),
+            FloorDiv(bounds.y + std::max(bounds.h, 1) - 1, cellSize)};
+}
+
+void SpatialHash::AddTo(int id, const CellSpan &span, const CellSpan *skip) {
+    for (int cellY = span.firstY; cellY <= span.lastY; cellY++) {
+        for (int cellX = span.firstX; cellX <= span.lastX; cellX++) {
+            if (skip != nullptr && skip->Contains(cellX, cellY)) continue;
+            cells[CellKey(cellX, cellY)].push_back(id);
+        }
+    }
+}
+
+void SpatialHash::RemoveFrom(int id, const CellSpan &span, const CellSpan *skip) {
+    for (int cellY = span.firstY; cellY <= span.lastY; cellY++) {
+        for (int cellX = span.firstX; cellX <= span.lastX; cellX++) {
+            if (skip != nullptr && skip->Contains(cellX, cellY)) continue;
+            auto cell = cells.find(CellKey(cellX, cellY));
+            if (cell == cells.end()) continue;
+            std::vector<int> &ids = cell->second;
+            auto found = std::find(ids.begin(), ids.end(), id);
+            if (found != ids.end()) {
+                *found = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty()) cells.erase(cell);
+        }
+    }
+}
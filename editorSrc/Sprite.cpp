@@ -24,6 +24,7 @@ Sprite::~Sprite() {
 // but is this the right place?
     SDL_FreeSurface(m_spriteSheet);
     m_spriteSheet = nullptr;
+    RenderStats::RemoveTexture(m_texture);
     SDL_DestroyTexture(m_texture);
 }
 
@@ -58,9 +59,21 @@ void Sprite::Update() {
 
 void Sprite::Render(SDL_Renderer *ren) {
     SDL_RenderCopy(ren, m_texture, &m_src, &m_dest);
+    RenderStats::CountDrawCalls();
 }
 
 
+void Sprite::Render(SDL_Renderer *ren, const Camera &camera) {
+    if (!camera.IsVisible(m_dest)) return;
+    SDL_Rect screenDest = camera.ToScreen(m_dest);
+    SDL_RenderCopy(ren, m_texture, &m_src, &screenDest);
+    RenderStats::CountDrawCalls();
+}
+
+SDL_Rect Sprite::GetBounds() const {
+    return {xPos, yPos, CHARACTER_WIDTH, CHARACTER_HEIGHT};
+}
+
 void Sprite::LoadImage(std::string filePath, SDL_Renderer *ren, const int spriteInfo[SPRITE_INFO_NUM]) {
     m_spriteSheet = IMG_Load(filePath.c_str());
     if (nullptr == m_spriteSheet) {
@@ -68,6 +81,7 @@ void Sprite::LoadImage(std::string filePath, SDL_Renderer *ren, const int sprite
     } else {
         SDL_Log("Allocated a bunch of memory to create identical game character");
         m_texture = SDL_CreateTextureFromSurface(ren, m_spriteSheet);
+        RenderStats::AddTexture(m_texture);
     }
     sheetCol = spriteInfo[FILE_COL];
     sheetRow = spriteInfo[FILE_ROW];
@@ -0,0 +1,205 @@
+/**
+ * @file TextRenderer.cpp
+ * @brief This file contains the renderer that draws text from a glyph atlas.
+ */
+#include <algorithm>
+#include "TextRenderer.hpp"
+
+// width of the glyph atlas, glyphs are packed into rows of this width
+const int ATLAS_WIDTH {256};
+// static strings cached at most, strings past that are laid out again on every use
+const size_t MAX_CACHED_LAYOUTS {256};
+
+TextRenderer::TextRenderer():atlas(nullptr),atlasWidth(0),atlasHeight(0),lineHeight(0) {
+}
+
+TextRenderer::~TextRenderer() {
+}
+
+bool TextRenderer::Init(SDL_Renderer *ren, const char *const fontPath, int pointSize) {
+    Destroy();
+    if (TTF_Init() < 0) {
+        SDL_Log("Failed to initialize SDL_ttf: %s", TTF_GetError());
+        return false;
+    }
+    TTF_Font *font = TTF_OpenFont(fontPath, pointSize);
+    if (nullptr == font) {
+        SDL_Log("Failed to load font %s: %s", fontPath, TTF_GetError());
+        TTF_Quit();
+        return false;
+    }
+    lineHeight = TTF_FontLineSkip(font);
+
+    // rasterize every glyph once and pack them into rows of the atlas
+    const SDL_Color white {0xFF, 0xFF, 0xFF, 0xFF};
+    std::vector<SDL_Surface*> surfaces;
+    int penX = 0, penY = 0, rowHeight = 0;
+    for (int c = TEXT_FIRST_GLYPH; c <= TEXT_LAST_GLYPH; c++) {
+        Glyph glyph {{0, 0, 0, 0}, 0};
+        int minX, maxX, minY, maxY;
+        TTF_GlyphMetrics(font, (Uint16)c, &minX, &maxX, &minY, &maxY, &glyph.advance);
+        // a one character string renders the glyph in a full cell, already placed on the baseline
+        const char text[2] = {(char)c, '\0'};
+        SDL_Surface *surface = TTF_RenderText_Blended(font, text, white);
+        if (surface != nullptr) {
+            if (penX + surface->w > ATLAS_WIDTH) {
+                penX = 0;
+                penY += rowHeight;
+                rowHeight = 0;
+            }
+            glyph.src = {penX, penY, surface->w, surface->h};
+            penX += surface->w;
+            rowHeight = std::max(rowHeight, surface->h);
+        }
+        surfaces.push_back(surface);
+        glyphs.push_back(glyph);
+    }
+    TTF_CloseFont(font);
+    atlasWidth = ATLAS_WIDTH;
+    atlasHeight = penY + rowHeight;
+
+    // new surfaces start out fully transparent
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, std::max(1, atlasHeight), 32, SDL_PIXELFORMAT_RGBA32);
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        if (surfaces[i] == nullptr) continue;
+        if (sheet != nullptr) {
+            // copy the coverage as it is instead of blending it onto the empty atlas
+            SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surfaces[i], nullptr, sheet, &glyphs[i].src);
+        }
+        SDL_FreeSurface(surfaces[i]);
+    }
+    if (nullptr == sheet) {
+        SDL_Log("Failed to create the glyph atlas: %s", SDL_GetError());
+        Destroy();
+        TTF_Quit();
+        return false;
+    }
+    atlas = SDL_CreateTextureFromSurface(ren, sheet);
+    SDL_FreeSurface(sheet);
+    TTF_Quit();
+    if (nullptr == atlas) {
+        SDL_Log("Failed to create the glyph atlas texture: %s", SDL_GetError());
+        Destroy();
+        return false;
+    }
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    RenderStats::AddTexture(atlas);
+    return true;
+}
+
+const TextRenderer::Glyph &TextRenderer::GetGlyph(char c) const {
+    if (c < TEXT_FIRST_GLYPH || c > TEXT_LAST_GLYPH) c = '?';
+    return glyphs[c - TEXT_FIRST_GLYPH];
+}
+
+void TextRenderer::Layout(const char *text, TextLayout &layout) const {
+    layout.src.clear();
+    layout.dst.clear();
+    layout.width = 0;
+    layout.height = 0;
+    if (glyphs.empty()) return;
+
+    int penX = 0, penY = 0;
+    for (; *text != '\0'; text++) {
+        char c = *text;
+        if (c == '\n') {
+            penX = 0;
+            penY += lineHeight;
+            continue;
+        }
+        const Glyph &glyph = GetGlyph(c);
+        // spaces move the pen but have nothing to draw
+        if (c != ' ' && glyph.src.w > 0) {
+            layout.src.push_back(glyph.src);
+            layout.dst.push_back({penX, penY, glyph.src.w, glyph.src.h});
+        }
+        penX += glyph.advance;
+        layout.width = std::max(layout.width, penX);
+    }
+    layout.height = penY + lineHeight;
+}
+
+const TextLayout &TextRenderer::GetLayout(const std::string &text) {
+    auto found = cache.find(text);
+    if (found != cache.end()) return found->second;
+    // dropping the cache would pull the layouts handed out so far from under their callers
+    if (cache.size() >= MAX_CACHED_LAYOUTS) {
+        Layout(text.c_str(), uncachedLayout);
+        return uncachedLayout;
+    }
+    TextLayout &layout = cache[text];
+    Layout(text.c_str(), layout);
+    return layout;
+}
+
+void TextRenderer::Draw(SDL_Renderer *ren, const TextLayout &layout, int x, int y, SDL_Color color) {
+    if (atlas == nullptr || layout.src.empty()) return;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // the whole string is one draw call of two triangles per glyph
+    size_t count = layout.src.size();
+    vertices.resize(count * 4);
+    indices.resize(count * 6);
+    float scaleU = 1.0f / atlasWidth, scaleV = 1.0f / atlasHeight;
+    for (size_t i = 0; i < count; i++) {
+        const SDL_Rect &src = layout.src[i];
+        const SDL_Rect &dst = layout.dst[i];
+        float left = (float)(x + dst.x), top = (float)(y + dst.y);
+        float right = left + dst.w, bottom = top + dst.h;
+        float u0 = src.x * scaleU, v0 = src.y * scaleV;
+        float u1 = (src.x + src.w) * scaleU, v1 = (src.y + src.h) * scaleV;
+        SDL_Vertex *quad = &vertices[i * 4];
+        quad[0] = {{left, top}, color, {u0, v0}};
+        quad[1] = {{right, top}, color, {u1, v0}};
+        quad[2] = {{right, bottom}, color, {u1, v1}};
+        quad[3] = {{left, bottom}, color, {u0, v1}};
+        int first = (int)(i * 4);
+        int *index = &indices[i * 6];
+        index[0] = first;
+        index[1] = first + 1;
+        index[2] = first + 2;
+        index[3] = first;
+        index[4] = first + 2;
+        index[5] = first + 3;
+    }
+    SDL_RenderGeometry(ren, atlas, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+    RenderStats::CountDrawCalls();
+#else
+    // older SDL has no geometry call, it still batches these copies since they share one texture
+    SDL_SetTextureColorMod(atlas, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas, color.a);
+    for (size_t i = 0; i < layout.src.size(); i++) {
+        SDL_Rect dst = layout.dst[i];
+        dst.x += x;
+        dst.y += y;
+        SDL_RenderCopy(ren, atlas, &layout.src[i], &dst);
+    }
+    RenderStats::CountDrawCalls((int)layout.src.size());
+#endif
+}
+
+void TextRenderer::DrawText(SDL_Renderer *ren, const std::string &text, int x, int y, SDL_Color color) {
+    Draw(ren, GetLayout(text), x, y, color);
+}
+
+void TextRenderer::DrawDynamicText(SDL_Renderer *ren, const char *text, int x, int y, SDL_Color color) {
+    Layout(text, scratchLayout);
+    Draw(ren, scratchLayout, x, y, color);
+}
+
+void TextRenderer::ClearCache() {
+    cache.clear();
+}
+
+void TextRenderer::Destroy() {
+    if (atlas != nullptr) {
+        RenderStats::RemoveTexture(atlas);
+        SDL_DestroyTexture(atlas);
+        atlas = nullptr;
+    }
+    glyphs.clear();
+    cache.clear();
+    atlasWidth = 0;
+    atlasHeight = 0;
+    lineHeight = 0;
+}
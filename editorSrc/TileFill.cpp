@@ -0,0 +1,170 @@
+/**
+ * @file TileFill.cpp
+ * @brief This file contains the fill tools of the level editor.
+ */
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <vector>
+#include "TileFill.hpp"
+
+namespace {
+
+// clip a rectangle of tiles to the map, false if nothing is left
+bool ClipToMap(const TileMap &map, const SDL_Rect &area, int &firstX, int &firstY, int &lastX, int &lastY) {
+    firstX = std::max(0, area.x);
+    firstY = std::max(0, area.y);
+    lastX = std::min(map.GetWidth(), area.x + area.w);
+    lastY = std::min(map.GetHeight(), area.y + area.h);
+    return firstX < lastX && firstY < lastY;
+}
+
+// what a flood fill reads in absent chunks, no tile has this id so the fill stops there
+const TileID ABSENT_TILE {INT16_MIN};
+
+// the part of one row a flood fill has read, whole chunks wide, and the columns it changed
+struct FillRow {
+    int first;
+    std::vector<TileID> tiles;
+    int dirtyFirst;
+    int dirtyLast;
+
+    FillRow():first(0),dirtyFirst(INT_MAX),dirtyLast(-1) {}
+};
+
+// read more of a row so that it holds column x, at least doubling what it holds so a long run is read in a few steps
+void GrowRow(const TileMap &map, int y, FillRow &row, int x) {
+    int size = (int)row.tiles.size();
+    int first = row.first, end = row.first + size;
+    if (size == 0) {
+        first = x;
+        end = x + 1;
+    } else if (x < first) {
+        first = std::min(x, first - size);
+    } else {
+        end = std::max(x + 1, end + size);
+    }
+    first = std::max(0, first - first % TILE_CHUNK_SIZE);
+    end = std::min(map.GetWidth(), end + (TILE_CHUNK_SIZE - end % TILE_CHUNK_SIZE) % TILE_CHUNK_SIZE);
+    std::vector<TileID> tiles(end - first);
+    // only the new columns are read, the ones held already may have been filled
+    auto read = [&](int from, int to) {
+        map.CopyRowSpan(from, y, tiles.data() + (from - first), to - from);
+        for (int chunkX = from / TILE_CHUNK_SIZE; from < to && chunkX <= (to - 1) / TILE_CHUNK_SIZE; chunkX++) {
+            if (!map.IsChunkAbsent(chunkX, y / TILE_CHUNK_SIZE)) continue;
+            int chunkFirst = std::max(from, chunkX * TILE_CHUNK_SIZE);
+            int chunkEnd = std::min(to, (chunkX + 1) * TILE_CHUNK_SIZE);
+            std::fill(tiles.begin() + (chunkFirst - first), tiles.begin() + (chunkEnd - first), ABSENT_TILE);
+        }
+    };
+    if (size == 0) {
+        read(first, end);
+    } else {
+        read(first, row.first);
+        std::copy(row.tiles.begin(), row.tiles.end(), tiles.begin() + (row.first - first));
+        read(row.first + size, end);
+    }
+    row.first = first;
+    row.tiles.swap(tiles);
+}
+
+}
+
+TileChangeSet FloodFill(TileMap &map, int x, int y, TileID id) {
+    TileChangeSet changes;
+    if (!map.IsEditable(x, y)) return changes;
+    TileID target = map.GetTile(x, y);
+    if (target == id) return changes;
+
+    int width = map.GetWidth(), height = map.GetHeight();
+    // only the rows the fill reaches get a buffer, each written back once
+    std::map<int, FillRow> rows;
+    // absent chunks read as ABSENT_TILE, so the fill stops at them like at any other tile
+    auto tileAt = [&](int rowY, FillRow &row, int tileX) {
+        if (tileX < row.first || tileX >= row.first + (int)row.tiles.size()) GrowRow(map, rowY, row, tileX);
+        return row.tiles[tileX - row.first];
+    };
+
+    struct Seed {
+        int x;
+        int y;
+    };
+    std::vector<Seed> seeds {{x, y}};
+    while (!seeds.empty()) {
+        Seed seed = seeds.back();
+        seeds.pop_back();
+        FillRow &row = rows[seed.y];
+        if (tileAt(seed.y, row, seed.x) != target) continue;
+
+        // grow the seed into the whole run of target tiles and fill it at once
+        int left = seed.x, right = seed.x;
+        while (left > 0 && tileAt(seed.y, row, left - 1) == target) left--;
+        while (right < width - 1 && tileAt(seed.y, row, right + 1) == target) right++;
+        std::fill(row.tiles.begin() + (left - row.first), row.tiles.begin() + (right - row.first + 1), id);
+        row.dirtyFirst = std::min(row.dirtyFirst, left);
+        row.dirtyLast = std::max(row.dirtyLast, right);
+
+        // one seed for each run of target tiles touching the span from above or below
+        for (int nextY : {seed.y - 1, seed.y + 1}) {
+            if (nextY < 0 || nextY >= height) continue;
+            FillRow &next = rows[nextY];
+            tileAt(nextY, next, left);
+            tileAt(nextY, next, right);
+            const TileID *tiles = &next.tiles[left - next.first];
+            for (int i = 0; i <= right - left; i++) {
+                if (tiles[i] == target && (i == 0 || tiles[i - 1] != target)) seeds.push_back({left + i, nextY});
+            }
+        }
+    }
+
+    for (const std::pair<const int, FillRow> &entry : rows) {
+        const FillRow &row = entry.second;
+        if (row.dirtyLast < 0) continue;
+        int count = row.dirtyLast - row.dirtyFirst + 1;
+        map.SetRowSpan(row.dirtyFirst, entry.first, &row.tiles[row.dirtyFirst - row.first], count);
+        changes.AddSpan(map.GetChunkCols(), row.dirtyFirst, entry.first, count);
+    }
+    changes.Finish();
+    return changes;
+}
+
+TileChangeSet FillRect(TileMap &map, const SDL_Rect &area, TileID id) {
+    TileChangeSet changes;
+    int firstX, firstY, lastX, lastY;
+    if (!ClipToMap(map, area, firstX, firstY, lastX, lastY)) return changes;
+    // every row gets the same span
+    std::vector<TileID> row(lastX - firstX, id);
+    for (int y = firstY; y < lastY; y++) {
+        map.SetRowSpan(firstX, y, row.data(), (int)row.size());
+        changes.AddSpan(map.GetChunkCols(), firstX, y, (int)row.size());
+    }
+    changes.Finish();
+    return changes;
+}
+
+TileChangeSet StampRect(TileMap &map, const SDL_Rect &area, const TileID *stamp, int stampWidth, int stampHeight) {
+    TileChangeSet changes;
+    int firstX, firstY, lastX, lastY;
+    if (stampWidth <= 0 || stampHeight <= 0 || !ClipToMap(map, area, firstX, firstY, lastX, lastY)) return changes;
+
+    // build each distinct row of the pattern once, from whole copies of a stamp row
+    int count = lastX - firstX;
+    std::vector<TileID> patternRows((size_t)stampHeight * count);
+    for (int stampY = 0; stampY < stampHeight; stampY++) {
+        const TileID *stampRow = stamp + (size_t)stampY * stampWidth;
+        TileID *out = &patternRows[(size_t)stampY * count];
+        int stampX = (firstX - area.x) % stampWidth;
+        for (int i = 0; i < count; ) {
+            int length = std::min(stampWidth - stampX, count - i);
+            std::copy(stampRow + stampX, stampRow + stampX + length, out + i);
+            i += length;
+            stampX = 0;
+        }
+    }
+    for (int y = firstY; y < lastY; y++) {
+        map.SetRowSpan(firstX, y, &patternRows[(size_t)((y - area.y) % stampHeight) * count], count);
+        changes.AddSpan(map.GetChunkCols(), firstX, y, count);
+    }
+    changes.Finish();
+    return changes;
+}
@@ -0,0 +1,365 @@
+/**
+ * @file TileMap.cpp
+ * @brief This file contains the grid of tile ids that makes up a level.
+ */
+#include <algorithm>
+#include "TileMap.hpp"
+#include "LevelFile.hpp"
+#include "LevelTextParser.hpp"
+#include "EditJournal.hpp"
+
+// number of tiles in a chunk
+const int CHUNK_TILES {TILE_CHUNK_SIZE * TILE_CHUNK_SIZE};
+
+TileMap::TileMap():storage(STORAGE_DENSE),journal(nullptr) {
+    Resize(0, 0);
+}
+
+TileMap::TileMap(int width, int height):storage(STORAGE_DENSE),journal(nullptr) {
+    Resize(width, height);
+}
+
+TileMap::~TileMap() {
+}
+
+void TileMap::Resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    chunkCols = (width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    chunkRows = (height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    // an empty map stores no chunk at all
+    chunks.clear();
+    chunks.resize(chunkCols * chunkRows);
+    writtenChunks.clear();
+    ResetChunkVersions();
+    editVersions.assign(chunkCols * chunkRows, 0);
+    absentChunks.assign(chunkCols * chunkRows, 0);
+    // the history belongs to the old grid
+    if (journal != nullptr) journal->Clear();
+}
+
+void TileMap::Assign(int width, int height, std::vector<TileID> &&newTiles) {
+    if ((int)newTiles.size() != width * height) {
+        SDL_Log("Tile count %d does not match a %dx%d map", (int)newTiles.size(), width, height);
+        return;
+    }
+    Resize(width, height);
+    for (int y = 0; y < height; y++) {
+        LoadRowSpan(0, y, &newTiles[(size_t)y * width], width);
+        // encode each finished row of chunks right away, so the map never holds more than one
+        // row of chunks uncompressed; the peak is still newTiles plus the encoded map
+        if ((y + 1) % TILE_CHUNK_SIZE == 0) Compact();
+    }
+    // give the dense grid back before the last chunks are encoded, clear() would keep its memory
+    std::vector<TileID>().swap(newTiles);
+    Compact();
+    // loading is not an edit, start from fresh versions
+    ResetChunkVersions();
+}
+
+bool TileMap::LoadFromFile(const std::string &filePath) {
+    // binary levels are read through their own loader
+    if (LevelFile::IsLevelFile(filePath)) {
+        LevelFile level;
+        if (!level.Open(filePath) || !level.CopyTo(*this)) return false;
+        Compact();
+        return true;
+    }
+    LevelTextParser parser;
+    if (!parser.ParseFile(filePath, *this)) {
+        for (const LevelParseError &error : parser.GetErrors()) {
+            SDL_Log("%s:%d: %s", filePath.c_str(), error.line, error.message.c_str());
+        }
+        return false;
+    }
+    return true;
+}
+
+bool TileMap::SaveToFile(const std::string &filePath) const {
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        SDL_Log("Failed to open level file %s", filePath.c_str());
+        return false;
+    }
+    std::vector<TileID> row(width);
+    for (int y = 0; y < height; y++) {
+        CopyRowSpan(0, y, row.data(), width);
+        for (int x = 0; x < width; x++) {
+            if (x > 0) file << "  ";
+            file << row[x];
+        }
+        file << "\n";
+    }
+    return file.good();
+}
+
+void TileMap::SetStorage(TILE_STORAGE mode) {
+    storage = mode;
+    writtenChunks.clear();
+    for (int i = 0; i < (int)chunks.size(); i++) {
+        if (chunks[i] == nullptr) continue;
+        if (storage == STORAGE_DENSE) {
+            EditChunk(i).written = false;
+        } else {
+            CompactChunk(i);
+        }
+    }
+}
+
+void TileMap::Compact() {
+    if (storage != STORAGE_SPARSE) return;
+    for (int chunkIndex : writtenChunks) CompactChunk(chunkIndex);
+    writtenChunks.clear();
+}
+
+size_t TileMap::GetMemoryUsage() const {
+    size_t bytes = chunks.capacity() * sizeof(std::unique_ptr<TileChunk>)
+                 + chunkVersions.capacity() * sizeof(unsigned int)
+                 + editVersions.capacity() * sizeof(unsigned int)
+                 + absentChunks.capacity() * sizeof(Uint8)
+                 + changedFlags.capacity() * sizeof(Uint8) + changedChunks.capacity() * sizeof(int);
+    for (const std::unique_ptr<TileChunk> &chunk : chunks) {
+        if (chunk == nullptr) continue;
+        bytes += sizeof(TileChunk) + chunk->tiles.capacity() * sizeof(TileID)
+               + chunk->runs.capacity() * sizeof(TileRun);
+    }
+    return bytes;
+}
+
+TileID TileMap::GetTile(int x, int y) const {
+    if (!InBounds(x, y)) return EMPTY_TILE;
+    const TileChunk *chunk = chunks[(y / TILE_CHUNK_SIZE) * chunkCols + x / TILE_CHUNK_SIZE].get();
+    if (chunk == nullptr) return EMPTY_TILE;
+    int localX = x % TILE_CHUNK_SIZE;
+    int row = y % TILE_CHUNK_SIZE;
+    if (chunk->IsDense()) return chunk->tiles[row * TILE_CHUNK_SIZE + localX];
+    // at most TILE_CHUNK_SIZE runs per row, so this stays constant time
+    for (int i = chunk->rowStart[row]; i < chunk->rowStart[row + 1]; i++) {
+        const TileRun &run = chunk->runs[i];
+        if (localX < run.start) break;
+        if (localX < run.start + run.length) return run.id;
+    }
+    return EMPTY_TILE;
+}
+
+void TileMap::SetTile(int x, int y, TileID id) {
+    if (!IsEditable(x, y)) return;
+    TileID oldId = GetTile(x, y);
+    if (oldId == id) return;
+    if (journal != nullptr && journal->IsRecording()) journal->Record(width, x, y, &oldId, &id, 1);
+    editVersions[(y / TILE_CHUNK_SIZE) * chunkCols + x / TILE_CHUNK_SIZE]++;
+    TileChunk &chunk = EditChunk((y / TILE_CHUNK_SIZE) * chunkCols + x / TILE_CHUNK_SIZE);
+    chunk.tiles[(y % TILE_CHUNK_SIZE) * TILE_CHUNK_SIZE + x % TILE_CHUNK_SIZE] = id;
+    MarkChanged(x, y);
+}
+
+void TileMap::SetRowSpan(int x, int y, const TileID *ids, int count) {
+    if (y < 0 || y >= height) return;
+    int firstX = std::max(0, x), lastX = std::min(width, x + count);
+    int rowStart = (y / TILE_CHUNK_SIZE) * chunkCols;
+    // write the run between two absent chunks
+    auto write = [&](int from, int to) {
+        if (from >= to) return;
+        if (journal != nullptr && journal->IsRecording()) {
+            journalIds.resize(to - from);
+            CopyRowSpan(from, y, journalIds.data(), to - from);
+            journal->Record(width, from, y, journalIds.data(), ids + (from - x), to - from);
+        }
+        LoadRowSpan(from, y, ids + (from - x), to - from);
+        for (int chunkX = from / TILE_CHUNK_SIZE; chunkX <= (to - 1) / TILE_CHUNK_SIZE; chunkX++) {
+            editVersions[rowStart + chunkX]++;
+        }
+    };
+    int runStart = firstX;
+    for (int chunkX = firstX / TILE_CHUNK_SIZE; firstX < lastX && chunkX <= (lastX - 1) / TILE_CHUNK_SIZE; chunkX++) {
+        if (!absentChunks[rowStart + chunkX]) continue;
+        write(runStart, std::max(runStart, chunkX * TILE_CHUNK_SIZE));
+        runStart = std::min(lastX, (chunkX + 1) * TILE_CHUNK_SIZE);
+    }
+    write(runStart, lastX);
+}
+
+void TileMap::LoadRowSpan(int x, int y, const TileID *ids, int count) {
+    if (y < 0 || y >= height) return;
+    // clip the run to the row
+    if (x < 0) {
+        ids -= x;
+        count += x;
+        x = 0;
+    }
+    count = std::min(count, width - x);
+    if (count <= 0) return;
+    int row = y % TILE_CHUNK_SIZE;
+    int chunkRowIndex = (y / TILE_CHUNK_SIZE) * chunkCols;
+    for (int tileX = x; tileX < x + count; ) {
+        int chunkX = tileX / TILE_CHUNK_SIZE;
+        int chunkLeft = chunkX * TILE_CHUNK_SIZE;
+        int segmentEnd = std::min(x + count, chunkLeft + TILE_CHUNK_SIZE);
+        const TileID *segment = ids + (tileX - x);
+        int length = segmentEnd - tileX;
+        // clearing tiles of a chunk that is not stored changes nothing
+        bool allEmpty = std::all_of(segment, segment + length, [](TileID id) { return id == EMPTY_TILE; });
+        if (!(allEmpty && chunks[chunkRowIndex + chunkX] == nullptr)) {
+            TileChunk &chunk = EditChunk(chunkRowIndex + chunkX);
+            std::copy(segment, segment + length, &chunk.tiles[row * TILE_CHUNK_SIZE + tileX - chunkLeft]);
+        }
+        tileX = segmentEnd;
+    }
+    MarkSpanChanged(x, y, count);
+}
+
+void TileMap::ClearChunk(int chunkX, int chunkY) {
+    if (chunkX < 0 || chunkY < 0 || chunkX >= chunkCols || chunkY >= chunkRows) return;
+    int chunkIndex = chunkY * chunkCols + chunkX;
+    // a chunk still waiting in writtenChunks is skipped by CompactChunk() once it is gone
+    chunks[chunkIndex].reset();
+    chunkVersions[chunkIndex]++;
+    NoteChanged(chunkIndex);
+}
+
+void TileMap::CopyRowSpan(int x, int y, TileID *out, int count) const {
+    std::fill(out, out + count, EMPTY_TILE);
+    ForEachTileRun(x, y, count, [&](int firstX, int length, TileID id) {
+        std::fill(out + (firstX - x), out + (firstX - x) + length, id);
+    });
+}
+
+bool TileMap::IsEditable(int x, int y) const {
+    return InBounds(x, y) && !absentChunks[(y / TILE_CHUNK_SIZE) * chunkCols + x / TILE_CHUNK_SIZE];
+}
+
+void TileMap::SetChunkAbsent(int chunkX, int chunkY, bool absent) {
+    if (chunkX < 0 || chunkY < 0 || chunkX >= chunkCols || chunkY >= chunkRows) return;
+    int chunkIndex = chunkY * chunkCols + chunkX;
+    if (absentChunks[chunkIndex] == (Uint8)absent) return;
+    absentChunks[chunkIndex] = absent;
+    NoteChanged(chunkIndex);
+}
+
+bool TileMap::IsChunkAbsent(int chunkX, int chunkY) const {
+    return absentChunks[chunkY * chunkCols + chunkX] != 0;
+}
+
+void TileMap::TakeChangedChunks(std::vector<int> &out) {
+    out.clear();
+    out.swap(changedChunks);
+    for (int chunkIndex : out) changedFlags[chunkIndex] = 0;
+}
+
+unsigned int TileMap::GetChunkVersion(int chunkX, int chunkY) const {
+    return chunkVersions[chunkY * chunkCols + chunkX];
+}
+
+unsigned int TileMap::GetChunkEditVersion(int chunkX, int chunkY) const {
+    return editVersions[chunkY * chunkCols + chunkX];
+}
+
+TileChunk &TileMap::EditChunk(int chunkIndex) {
+    std::unique_ptr<TileChunk> &chunk = chunks[chunkIndex];
+    if (chunk == nullptr) {
+        chunk.reset(new TileChunk());
+        chunk->tiles.assign(CHUNK_TILES, EMPTY_TILE);
+        std::fill(chunk->rowStart, chunk->rowStart + TILE_CHUNK_SIZE + 1, 0);
+        chunk->written = false;
+    } else if (!chunk->IsDense()) {
+        chunk->tiles.assign(CHUNK_TILES, EMPTY_TILE);
+        for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+            for (int i = chunk->rowStart[row]; i < chunk->rowStart[row + 1]; i++) {
+                const TileRun &run = chunk->runs[i];
+                std::fill_n(&chunk->tiles[row * TILE_CHUNK_SIZE + run.start], run.length, run.id);
+            }
+        }
+        chunk->runs.clear();
+        chunk->runs.shrink_to_fit();
+    }
+    if (storage == STORAGE_SPARSE && !chunk->written) {
+        chunk->written = true;
+        writtenChunks.push_back(chunkIndex);
+    }
+    return *chunk;
+}
+
+void TileMap::CompactChunk(int chunkIndex) {
+    std::unique_ptr<TileChunk> &chunk = chunks[chunkIndex];
+    if (chunk == nullptr) return;
+    chunk->written = false;
+    if (!chunk->IsDense()) return;
+    std::vector<TileRun> runs;
+    Uint16 rowStart[TILE_CHUNK_SIZE + 1];
+    for (int row = 0; row < TILE_CHUNK_SIZE; row++) {
+        rowStart[row] = (Uint16)runs.size();
+        const TileID *tiles = &chunk->tiles[row * TILE_CHUNK_SIZE];
+        for (int x = 0; x < TILE_CHUNK_SIZE; ) {
+            int end = x + 1;
+            while (end < TILE_CHUNK_SIZE && tiles[end] == tiles[x]) end++;
+            if (tiles[x] != EMPTY_TILE) runs.push_back({tiles[x], (Uint8)x, (Uint8)(end - x)});
+            x = end;
+        }
+    }
+    rowStart[TILE_CHUNK_SIZE] = (Uint16)runs.size();
+    if (runs.empty()) {
+        chunk.reset();
+        return;
+    }
+    // keep the plain array when the runs would not be smaller
+    if (runs.size() * sizeof(TileRun) >= CHUNK_TILES * sizeof(TileID)) return;
+    chunk->runs.assign(runs.begin(), runs.end());
+    std::copy(rowStart, rowStart + TILE_CHUNK_SIZE + 1, chunk->rowStart);
+    chunk->tiles.clear();
+    chunk->tiles.shrink_to_fit();
+}
+
+void TileMap::MarkChanged(int x, int y) {
+    int chunkIndex = (y / TILE_CHUNK_SIZE) * chunkCols + x / TILE_CHUNK_SIZE;
+    chunkVersions[chunkIndex]++;
+    NoteChanged(chunkIndex);
+}
+
+void TileMap::MarkSpanChanged(int x, int y, int count) {
+    int rowStart = (y / TILE_CHUNK_SIZE) * chunkCols;
+    for (int chunkX = x / TILE_CHUNK_SIZE; chunkX <= (x + count - 1) / TILE_CHUNK_SIZE; chunkX++) {
+        chunkVersions[rowStart + chunkX]++;
+        NoteChanged(rowStart + chunkX);
+    }
+}
+
+void TileMap::NoteChanged(int chunkIndex) {
+    if (changedFlags[chunkIndex]) return;
+    changedFlags[chunkIndex] = 1;
+    changedChunks.push_back(chunkIndex);
+}
+
+void TileMap::ResetChunkVersions() {
+    // every chunk moves past any version seen before, so caches built from the old
+    // contents are stale and a fresh cache entry (version 0) is too
+    unsigned int next = 1;
+    for (unsigned int version : chunkVersions) next = std::max(next, version + 1);
+    chunkVersions.assign(chunkCols * chunkRows, next);
+    changedFlags.assign(chunkCols * chunkRows, 1);
+    changedChunks.resize(chunkCols * chunkRows);
+    for (int chunkIndex = 0; chunkIndex < chunkCols * chunkRows; chunkIndex++) changedChunks[chunkIndex] = chunkIndex;
+}
+
+void TileChangeSet::AddSpan(int chunkCols, int x, int y, int count) {
+    if (count <= 0) return;
+    if (tileCount == 0) {
+        area = {x, y, count, 1};
+    } else {
+        int right = std::max(area.x + area.w, x + count), bottom = std::max(area.y + area.h, y + 1);
+        area.x = std::min(area.x, x);
+        area.y = std::min(area.y, y);
+        area.w = right - area.x;
+        area.h = bottom - area.y;
+    }
+    tileCount += count;
+    int rowIndex = (y / TILE_CHUNK_SIZE) * chunkCols;
+    for (int chunkX = x / TILE_CHUNK_SIZE; chunkX <= (x + count - 1) / TILE_CHUNK_SIZE; chunkX++) {
+        // spans of one operation usually arrive row by row, so repeats are mostly adjacent
+        if (chunks.empty() || chunks.back() != rowIndex + chunkX) chunks.push_back(rowIndex + chunkX);
+    }
+}
+
+void TileChangeSet::Finish() {
+    std::sort(chunks.begin(), chunks.end());
+    chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+}
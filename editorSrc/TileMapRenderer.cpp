@@ -0,0 +1,123 @@
+/**
+ * @file TileMapRenderer.cpp
+ * @brief This file contains the renderer that draws a TileMap through baked chunk textures.
+ */
+#include <algorithm>
+#include "TileMapRenderer.hpp"
+
+// size of a chunk texture in pixels
+const int CHUNK_PIXELS {TILE_CHUNK_SIZE * TILE_SIZE};
+
+TileMapRenderer::TileMapRenderer():tileMap(nullptr),tileSheet(nullptr),sheetCols(0) {
+}
+
+TileMapRenderer::~TileMapRenderer() {
+}
+
+bool TileMapRenderer::Init(SDL_Renderer *ren, const char *const tileSheetPath) {
+    SDL_Surface *sheet = SDL_LoadBMP(tileSheetPath);
+    if (nullptr == sheet) {
+        SDL_Log("Failed to load tile sheet %s", tileSheetPath);
+        return false;
+    }
+    sheetCols = sheet->w / TILE_SIZE;
+    tileSheet = SDL_CreateTextureFromSurface(ren, sheet);
+    SDL_FreeSurface(sheet);
+    RenderStats::AddTexture(tileSheet);
+    return tileSheet != nullptr;
+}
+
+void TileMapRenderer::SetTileMap(const TileMap *map) {
+    ClearChunks();
+    tileMap = map;
+    if (tileMap == nullptr) return;
+    int chunkCount = tileMap->GetChunkCols() * tileMap->GetChunkRows();
+    chunkTextures.assign(chunkCount, nullptr);
+    bakedVersions.assign(chunkCount, 0);
+}
+
+void TileMapRenderer::InvalidateAll() {
+    std::fill(bakedVersions.begin(), bakedVersions.end(), 0);
+}
+
+void TileMapRenderer::Render(SDL_Renderer *ren, const Camera &camera) {
+    if (tileMap == nullptr || tileSheet == nullptr) return;
+    // only the chunks that overlap the view
+    TileRange visible = camera.GetVisibleRange(CHUNK_PIXELS, tileMap->GetChunkCols(), tileMap->GetChunkRows());
+    for (int chunkY = visible.firstY; chunkY <= visible.lastY; chunkY++) {
+        for (int chunkX = visible.firstX; chunkX <= visible.lastX; chunkX++) {
+            int index = chunkY * tileMap->GetChunkCols() + chunkX;
+            if (bakedVersions[index] != tileMap->GetChunkVersion(chunkX, chunkY)) {
+                BakeChunk(ren, chunkX, chunkY);
+            }
+            if (chunkTextures[index] == nullptr) continue;
+            SDL_Rect dest = camera.ToScreen({chunkX * CHUNK_PIXELS, chunkY * CHUNK_PIXELS, CHUNK_PIXELS, CHUNK_PIXELS});
+            SDL_RenderCopy(ren, chunkTextures[index], nullptr, &dest);
+            RenderStats::CountDrawCalls();
+        }
+    }
+}
+
+void TileMapRenderer::Destroy() {
+    ClearChunks();
+    RenderStats::RemoveTexture(tileSheet);
+    SDL_DestroyTexture(tileSheet);
+    tileSheet = nullptr;
+    tileMap = nullptr;
+}
+
+void TileMapRenderer::BakeChunk(SDL_Renderer *ren, int chunkX, int chunkY) {
+    int index = chunkY * tileMap->GetChunkCols() + chunkX;
+    bakedVersions[index] = tileMap->GetChunkVersion(chunkX, chunkY);
+
+    int startX = chunkX * TILE_CHUNK_SIZE;
+    int startY = chunkY * TILE_CHUNK_SIZE;
+    bool hasTiles = false;
+    for (int y = startY; y < startY + TILE_CHUNK_SIZE && !hasTiles; y++) {
+        tileMap->ForEachTileRun(startX, y, TILE_CHUNK_SIZE, [&](int, int, TileID) { hasTiles = true; });
+    }
+    // empty chunks are skipped when rendering, no need to keep a texture around
+    SDL_Texture *&chunk = chunkTextures[index];
+    if (!hasTiles) {
+        RenderStats::RemoveTexture(chunk);
+        SDL_DestroyTexture(chunk);
+        chunk = nullptr;
+        return;
+    }
+    if (chunk == nullptr) {
+        chunk = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                  CHUNK_PIXELS, CHUNK_PIXELS);
+        if (chunk == nullptr) {
+            SDL_Log("Failed to create chunk texture: %s", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(chunk, SDL_BLENDMODE_BLEND);
+        RenderStats::AddTexture(chunk);
+    }
+
+    SDL_Texture *previousTarget = SDL_GetRenderTarget(ren);
+    SDL_SetRenderTarget(ren, chunk);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
+    SDL_RenderClear(ren);
+    for (int y = startY; y < startY + TILE_CHUNK_SIZE; y++) {
+        // empty tiles never reach the callback
+        tileMap->ForEachTileRun(startX, y, TILE_CHUNK_SIZE, [&](int firstX, int length, TileID id) {
+            SDL_Rect src = {(id % sheetCols) * TILE_SIZE, (id / sheetCols) * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+            for (int x = firstX; x < firstX + length; x++) {
+                SDL_Rect dest = {(x - startX) * TILE_SIZE, (y - startY) * TILE_SIZE, TILE_SIZE, TILE_SIZE};
+                SDL_RenderCopy(ren, tileSheet, &src, &dest);
+            }
+            RenderStats::CountDrawCalls(length);
+        });
+    }
+    SDL_SetRenderTarget(ren, previousTarget);
+}
+
+void TileMapRenderer::ClearChunks() {
+    for (SDL_Texture *chunk : chunkTextures) {
+        RenderStats::RemoveTexture(chunk);
+        SDL_DestroyTexture(chunk);
+    }
+    chunkTextures.clear();
+    bakedVersions.clear();
+}
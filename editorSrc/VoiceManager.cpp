@@ -0,0 +1,177 @@
+/**
+ * @file VoiceManager.cpp
+ * @brief This file contains the budget that decides which sound effects get a voice.
+ */
+#include <algorithm>
+#include <cmath>
+#include "VoiceManager.hpp"
+
+VoiceManager::VoiceManager():mixer(nullptr),listenerX(0),listenerY(0),coalesced(0),culled(0) {
+    voices.reserve(VOICE_BUDGET);
+}
+
+VoiceManager::~VoiceManager() {
+}
+
+void VoiceManager::SetMixer(AudioMixer *mixer) {
+    StopAll();
+    this->mixer = mixer;
+}
+
+void VoiceManager::SetSoundRules(SoundID sound, int priority, int maxInstances) {
+    if (sound < 0) return;
+    SoundState &state = GetState(sound);
+    state.priority = priority;
+    state.maxInstances = maxInstances;
+}
+
+void VoiceManager::SetListener(int x, int y) {
+    listenerX = x;
+    listenerY = y;
+}
+
+void VoiceManager::Trigger(SoundID sound, int x, int y, float volume) {
+    if (sound < 0) return;
+    float dx = (float)(x - listenerX), dy = (float)(y - listenerY);
+    float attenuation = 1.0f - std::sqrt(dx * dx + dy * dy) / VOICE_AUDIBLE_DISTANCE;
+    // sounds too far away to be heard never compete for a voice
+    if (attenuation <= 0 || volume <= 0) {
+        culled++;
+        return;
+    }
+    float pan = std::min(std::max(dx / VOICE_AUDIBLE_DISTANCE, -1.0f), 1.0f);
+    AddTrigger(sound, volume * attenuation, pan);
+}
+
+void VoiceManager::Trigger(SoundID sound, float volume) {
+    if (sound < 0) return;
+    if (volume <= 0) {
+        culled++;
+        return;
+    }
+    AddTrigger(sound, volume, 0);
+}
+
+void VoiceManager::Update() {
+    RetireFinished();
+    if (triggered.empty()) return;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // the most important triggers claim voices first
+    std::sort(triggered.begin(), triggered.end(), [this](SoundID a, SoundID b) {
+        const SoundState &first = sounds[a], &second = sounds[b];
+        if (first.priority != second.priority) return first.priority > second.priority;
+        return first.volume > second.volume;
+    });
+    for (SoundID sound : triggered) {
+        SoundState &state = sounds[sound];
+        state.triggered = false;
+        if (mixer == nullptr) continue;
+        // a sound over its instance limit may only replace one of its own voices
+        bool full = state.playing >= state.maxInstances;
+        if (full || (int)voices.size() >= VOICE_BUDGET) {
+            int victim = FindVictim(full ? sound : -1, state.priority, state.volume);
+            if (victim < 0) {
+                culled++;
+                continue;
+            }
+            StealVoice(victim);
+        }
+        VoiceHandle handle = mixer->Play(sound, state.volume, state.pan);
+        if (handle == 0) {
+            culled++;
+            continue;
+        }
+        std::chrono::duration<double> length(mixer->GetSoundSeconds(sound));
+        voices.push_back({handle, sound, state.priority, state.volume,
+                          now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(length)});
+        state.playing++;
+    }
+    triggered.clear();
+}
+
+void VoiceManager::StopAll() {
+    for (const ActiveVoice &voice : voices) {
+        if (mixer != nullptr) mixer->StopVoice(voice.handle);
+    }
+    voices.clear();
+    for (SoundState &state : sounds) {
+        state.playing = 0;
+        state.triggered = false;
+    }
+    triggered.clear();
+}
+
+VoiceManager::SoundState &VoiceManager::GetState(SoundID sound) {
+    if (sound >= (int)sounds.size()) {
+        sounds.resize(sound + 1, {0, VOICE_DEFAULT_INSTANCES, 0, false, 0, 0});
+        // every sound is in the trigger list at most once, so it never has to grow during an update
+        triggered.reserve(sounds.size());
+    }
+    return sounds[sound];
+}
+
+void VoiceManager::AddTrigger(SoundID sound, float volume, float pan) {
+    SoundState &state = GetState(sound);
+    if (state.triggered) {
+        // the same sound twice in one update is heard as one, as loud as the loudest
+        coalesced++;
+        if (volume > state.volume) {
+            state.volume = volume;
+            state.pan = pan;
+        }
+        return;
+    }
+    state.triggered = true;
+    state.volume = volume;
+    state.pan = pan;
+    triggered.push_back(sound);
+}
+
+void VoiceManager::RetireFinished() {
+    if (mixer == nullptr) return;
+    for (size_t i = 0; i < voices.size(); ) {
+        // also retires voices the mixer dropped because all of its own voices were busy
+        if (mixer->IsVoicePlaying(voices[i].handle)) {
+            i++;
+            continue;
+        }
+        sounds[voices[i].sound].playing--;
+        voices[i] = voices.back();
+        voices.pop_back();
+    }
+}
+
+int VoiceManager::FindVictim(SoundID sound, int priority, float volume) const {
+    int victim = -1;
+    for (int i = 0; i < (int)voices.size(); i++) {
+        const ActiveVoice &voice = voices[i];
+        if (sound >= 0 && voice.sound != sound) continue;
+        // lower priority first, then quieter, then the one closest to its end
+        if (victim >= 0) {
+            const ActiveVoice &weakest = voices[victim];
+            if (voice.priority != weakest.priority) {
+                if (voice.priority > weakest.priority) continue;
+            } else if (voice.volume != weakest.volume) {
+                if (voice.volume > weakest.volume) continue;
+            } else if (voice.end >= weakest.end) {
+                continue;
+            }
+        }
+        victim = i;
+    }
+    if (victim < 0) return -1;
+    // the new sound must matter more than the voice it takes
+    const ActiveVoice &weakest = voices[victim];
+    if (weakest.priority != priority) return weakest.priority < priority ? victim : -1;
+    return weakest.volume < volume ? victim : -1;
+}
+
+void VoiceManager::StealVoice(int index) {
+    ActiveVoice &voice = voices[index];
+    if (mixer != nullptr) mixer->StopVoice(voice.handle);
+    sounds[voice.sound].playing--;
+    culled++;
+    voices[index] = voices.back();
+    voices.pop_back();
+}
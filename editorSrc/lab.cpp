@@ -4,10 +4,68 @@
 
 #include "SDLGraphicsProgram.hpp"
 #include "ResourceManager.hpp"
+#include "LevelFile.hpp"
+#include "Benchmarks.hpp"
 
 int main(int argc, char** argv){
+	// spriteEditor --convert-level <input> <output> [--rle]
+	// converts a text level to binary or a binary level to text and exits
+	if(argc >= 4 && std::string(argv[1]) == "--convert-level"){
+		bool compress = argc >= 5 && std::string(argv[4]) == "--rle";
+		if(!LevelFile::Convert(argv[2], argv[3], compress)){
+			std::cout << "Failed to convert " << argv[2] << "\n";
+			return 1;
+		}
+		return 0;
+	}
+	// spriteEditor --bench-level-parser [size]
+	if(argc >= 2 && std::string(argv[1]) == "--bench-level-parser"){
+		return RunLevelParserBenchmark(argc >= 3 ? atoi(argv[2]) : 4096);
+	}
+	// spriteEditor --bench-voices [entities]
+	if(argc >= 2 && std::string(argv[1]) == "--bench-voices"){
+		return RunVoiceBenchmark(argc >= 3 ? atoi(argv[2]) : 500);
+	}
+	// spriteEditor [--record <log> | --replay <log>] [--headless] [--uncapped]
+	//              [--fast-forward <updates> [--render-every <updates>]] [--discard-autosave]
+	RunOptions options;
+	for(int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		if(arg == "--record" && i + 1 < argc){
+			options.recordPath = argv[++i];
+		}else if(arg == "--replay" && i + 1 < argc){
+			options.replayPath = argv[++i];
+		}else if(arg == "--headless"){
+			options.headless = true;
+		}else if(arg == "--uncapped"){
+			options.uncapped = true;
+		}else if(arg == "--fast-forward" && i + 1 < argc){
+			options.fastForwardTicks = atoi(argv[++i]);
+		}else if(arg == "--render-every" && i + 1 < argc){
+			options.renderEvery = atoi(argv[++i]);
+		}else if(arg == "--discard-autosave"){
+			options.discardAutosave = true;
+		}else{
+			std::cout << "Unknown argument " << arg << "\n";
+			return 1;
+		}
+	}
+	if(!options.recordPath.empty() && !options.replayPath.empty()){
+		std::cout << "A session cannot be recorded and replayed at once\n";
+		return 1;
+	}
+	// without a replay or a fast-forward there is nothing to run
+	if(options.headless && options.replayPath.empty() && options.fastForwardTicks <= 0){
+		std::cout << "--headless needs --replay or --fast-forward\n";
+		return 1;
+	}
+	// a fast-forward reads input only now and then, too rarely to record it
+	if(options.fastForwardTicks > 0 && !options.recordPath.empty()){
+		std::cout << "A fast-forward cannot be recorded\n";
+		return 1;
+	}
 	// Create an instance of an object for a SDLGraphicsProgram
-	SDLGraphicsProgram mySDLGraphicsProgram(WINDOW_WIDTH,WINDOW_HEIGHT);
+	SDLGraphicsProgram mySDLGraphicsProgram(WINDOW_WIDTH,WINDOW_HEIGHT,options);
 	// Run our program forever
 	mySDLGraphicsProgram.loop();
 	mySDLGraphicsProgram.destroy();
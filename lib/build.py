@@ -17,17 +17,17 @@ LIBRARIES=""            # What libraries do we want to include
 if platform.system()=="Linux":
     ARGUMENTS="-g -D LINUX" # -D is a #define sent to preprocessor
     INCLUDE_DIR_2="-I ../editorInclude/ ../lib/ ../editorInclude/SDL2"
-    LIBRARIES="-lSDL2 -lSDL2_ttf -lSDL2_mixer -ldl"
+    LIBRARIES="-lSDL2 -lSDL2_ttf -lSDL2_mixer -ldl -pthread"
 elif platform.system()=="Darwin":
     ARGUMENTS="-g -D MAC" # -D is a #define sent to the preprocessor.
     INCLUDE_DIR_2="-I../editorInclude/ -I../editorInclude/SDL2 -I/Library/Frameworks/SDL2.framework/Headers"
-    LIBRARIES="-F/Library/Frameworks -framework SDL2"
+    LIBRARIES="-F/Library/Frameworks -framework SDL2 -framework SDL2_ttf -framework SDL2_mixer -pthread"
 elif platform.system()=="Windows":
     COMPILER="g++ -std=c++17" # Note we use g++ here as it is more likely what you have
     ARGUMENTS="-g -D MINGW -std=c++17 -static-libgcc -static-libstdc++" 
     INCLUDE_DIR_2="-L../lib -I../editorInclude/ -I../editorInclude/SDL2"
     EXECUTABLE_2="spriteEditor.exe"
-    LIBRARIES="-lmingw32 -lSDL2main -lSDL2 -lSDL2_ttf -lSDL2_image -lSDL2_mixer"
+    LIBRARIES="-lmingw32 -lSDL2main -lSDL2 -lSDL2_ttf -lSDL2_image -lSDL2_mixer -lpsapi"
 # (2)=================== Platform specific configuration ===================== #
 
 # (3)====================== Building the Executable ========================== #